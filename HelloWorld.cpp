@@ -3,6 +3,8 @@
 
 
 #include <iostream>
+#include <cstdio>
+#include <ctime>
 #include <CreationSplice.h>
 
 using namespace CreationSplice;
@@ -25,6 +27,39 @@ int main( int argc, const char* argv[] )
   // // evaluate the node
   node.evaluate();
 
+  // time key lookups in a large dict, through the runtime and through
+  // a VariantDictIndex built over it
+  const unsigned int keyCount = 50000;
+  char key[32];
+  CreationCore::Variant dict = CreationCore::Variant::CreateDict();
+  for(unsigned int i=0;i<keyCount;i++)
+  {
+    sprintf(key, "key%u", i);
+    dict.setDictValue(key, CreationCore::Variant::CreateUInt32(i));
+  }
+
+  unsigned int found = 0;
+  clock_t start = clock();
+  for(unsigned int i=0;i<keyCount;i++)
+  {
+    sprintf(key, "key%u", i);
+    if(dict.getDictValue(key))
+      found++;
+  }
+  double dictSeconds = double(clock() - start) / CLOCKS_PER_SEC;
+
+  start = clock();
+  CreationCore::VariantDictIndex index(dict);
+  for(unsigned int i=0;i<keyCount;i++)
+  {
+    sprintf(key, "key%u", i);
+    if(index.find(key))
+      found++;
+  }
+  double indexSeconds = double(clock() - start) / CLOCKS_PER_SEC;
+
+  cout << keyCount << " dict lookups: " << dictSeconds << "s, indexed including the build: " << indexSeconds << "s (" << found << " found)" << endl;
+
   Finalize();
 
   return 0;
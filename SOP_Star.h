@@ -5,6 +5,8 @@
 
 #include <SOP/SOP_Node.h>
 
+namespace CreationSplice { class Node; }
+
 namespace MIX {
 class SOP_Star : public SOP_Node
 {
@@ -19,6 +21,10 @@ public:
     /// This optional data stores the list of local variables.
     static CH_LocalVariable	 myVariables[];
 
+    /// Applies pending reloads of file bound KL operators and recooks the
+    /// SOPs whose node binds one of them. Runs from Houdini's event loop.
+    static void			 applyKLOperatorReloads();
+
 protected:
 	     SOP_Star(OP_Network *net, const char *name, OP_Operator *op);
     virtual ~SOP_Star();
@@ -62,6 +68,10 @@ private:
     /// Another use for local data is a cache to store expensive calculations.
     int		myCurrPoint;
     int		myTotalPoints;
+
+    /// The Splice node is kept across cooks, so that reloads of its KL
+    /// operators can recook this SOP.
+    CreationSplice::Node	*myNode;
 };
 } // End MIX namespace
 
@@ -1729,6 +1729,19 @@ The following example code shows the use of the C++ language interface to CAPI.
 # if defined(FEC_PROVIDE_STL_BINDINGS)
 #  include <string>
 # endif
+# if !defined(_WIN32)
+#  include <pthread.h>
+#  include <time.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <dirent.h>
+#  if defined(__linux__)
+#   include <sys/syscall.h>
+#  endif
+#  define FEC_HAS_THREADS 1
+# endif
 
 namespace CreationCore
 {
@@ -2454,6 +2467,475 @@ namespace CreationCore
 #endif
   };
   
+  /*
+   * C++ - Small and Interned Strings
+   */
+
+  inline uint32_t HashString( char const *data, uint32_t length )
+  {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for ( uint32_t i=0; i<length; ++i )
+    {
+      hash ^= uint8_t( data[i] );
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+
+  inline uint32_t HashString( char const *cstr )
+  {
+    return HashString( cstr, uint32_t( strlen( cstr ) ) );
+  }
+
+  /*!
+   * A string that keeps up to InlineCapacity characters inside the
+   * object itself and only goes to the heap for longer content.  Used
+   * to cache identifiers (port names, members, data types) that are
+   * almost always short.
+   */
+  class SmallString
+  {
+  public:
+
+    enum { InlineCapacity = 31 };
+
+  private:
+
+    char *m_data;
+    uint32_t m_length;
+    char m_inline[InlineCapacity + 1];
+
+  public:
+
+    SmallString()
+      : m_data( m_inline )
+      , m_length( 0 )
+    {
+      m_inline[0] = '\0';
+    }
+
+    SmallString( char const *data, uint32_t length )
+      : m_data( m_inline )
+      , m_length( 0 )
+    {
+      assign( data, length );
+    }
+
+    SmallString( char const *cstr )
+      : m_data( m_inline )
+      , m_length( 0 )
+    {
+      assign( cstr, uint32_t( strlen( cstr ) ) );
+    }
+
+    SmallString( SmallString const &that )
+      : m_data( m_inline )
+      , m_length( 0 )
+    {
+      assign( that.m_data, that.m_length );
+    }
+
+    SmallString &operator =( SmallString const &that )
+    {
+      if ( this != &that )
+        assign( that.m_data, that.m_length );
+      return *this;
+    }
+
+    ~SmallString()
+    {
+      if ( m_data != m_inline )
+        free( m_data );
+    }
+
+    void assign( char const *data, uint32_t length )
+    {
+      if ( length > InlineCapacity )
+      {
+        char *heapData = (char *)malloc( length + 1 );
+        if ( !heapData )
+          Exception::Throw( "SmallString: out of memory" );
+        memcpy( heapData, data, length );
+        if ( m_data != m_inline )
+          free( m_data );
+        m_data = heapData;
+      }
+      else
+      {
+        memmove( m_inline, data, length );
+        if ( m_data != m_inline )
+          free( m_data );
+        m_data = m_inline;
+      }
+      m_data[length] = '\0';
+      m_length = length;
+    }
+
+    void assign( Variant const &stringVariant )
+    {
+      if ( stringVariant.isString() )
+        assign( stringVariant.getStringData(), stringVariant.getStringLength() );
+      else
+        assign( "", 0 );
+    }
+
+    char const *getData() const
+    {
+      return m_data;
+    }
+
+    char const *getCString() const
+    {
+      return m_data;
+    }
+
+    uint32_t getLength() const
+    {
+      return m_length;
+    }
+
+    bool isEmpty() const
+    {
+      return m_length == 0;
+    }
+
+    bool isInline() const
+    {
+      return m_data == m_inline;
+    }
+
+    bool equals( char const *data, uint32_t length ) const
+    {
+      return m_length == length && memcmp( m_data, data, length ) == 0;
+    }
+
+    bool equals( char const *cstr ) const
+    {
+      return equals( cstr, uint32_t( strlen( cstr ) ) );
+    }
+  };
+
+  /*!
+   * Interns identifier strings.  Every distinct string is stored once
+   * and the returned handle stays valid, and unique for its content,
+   * for the lifetime of the pool, so handles can be compared by
+   * pointer.  Not thread-safe; each owner keeps its own pool.
+   */
+  class StringPool
+  {
+  private:
+
+    struct Chunk
+    {
+      Chunk *next;
+      uint32_t capacity;
+      uint32_t used;
+      char data[1];
+    };
+
+    struct Entry
+    {
+      char const *data;
+      uint32_t length;
+      uint32_t hash;
+    };
+
+    Chunk *m_chunks;
+    Entry *m_entries;
+    uint32_t m_count;
+    uint32_t m_bucketMask;
+
+    StringPool( StringPool const & );
+    StringPool &operator =( StringPool const & );
+
+    char *store( char const *data, uint32_t length )
+    {
+      if ( !m_chunks || m_chunks->capacity - m_chunks->used < length + 1 )
+      {
+        uint32_t capacity = length + 1 > 4096 ? length + 1 : 4096;
+        Chunk *chunk = (Chunk *)malloc( sizeof(Chunk) + capacity );
+        if ( !chunk )
+          Exception::Throw( "StringPool: out of memory" );
+        chunk->next = m_chunks;
+        chunk->capacity = capacity;
+        chunk->used = 0;
+        m_chunks = chunk;
+      }
+      char *result = &m_chunks->data[m_chunks->used];
+      memcpy( result, data, length );
+      result[length] = '\0';
+      m_chunks->used += length + 1;
+      return result;
+    }
+
+    void grow()
+    {
+      uint32_t bucketCount = m_entries ? ( m_bucketMask + 1 ) * 2 : 64;
+      Entry *entries = (Entry *)calloc( bucketCount, sizeof(Entry) );
+      if ( !entries )
+        Exception::Throw( "StringPool: out of memory" );
+      uint32_t bucketMask = bucketCount - 1;
+      if ( m_entries )
+      {
+        for ( uint32_t i=0; i<=m_bucketMask; ++i )
+        {
+          if ( !m_entries[i].data )
+            continue;
+          uint32_t bucket = m_entries[i].hash & bucketMask;
+          while ( entries[bucket].data )
+            bucket = ( bucket + 1 ) & bucketMask;
+          entries[bucket] = m_entries[i];
+        }
+        free( m_entries );
+      }
+      m_entries = entries;
+      m_bucketMask = bucketMask;
+    }
+
+    Entry *lookup( char const *data, uint32_t length, uint32_t hash ) const
+    {
+      uint32_t bucket = hash & m_bucketMask;
+      for ( ;; )
+      {
+        Entry *entry = &m_entries[bucket];
+        if ( !entry->data
+          || ( entry->hash == hash
+            && entry->length == length
+            && memcmp( entry->data, data, length ) == 0 ) )
+          return entry;
+        bucket = ( bucket + 1 ) & m_bucketMask;
+      }
+    }
+
+  public:
+
+    StringPool()
+      : m_chunks( 0 )
+      , m_entries( 0 )
+      , m_count( 0 )
+      , m_bucketMask( 0 )
+    {
+    }
+
+    ~StringPool()
+    {
+      while ( m_chunks )
+      {
+        Chunk *next = m_chunks->next;
+        free( m_chunks );
+        m_chunks = next;
+      }
+      free( m_entries );
+    }
+
+    char const *intern( char const *data, uint32_t length )
+    {
+      if ( !m_entries || ( m_count + 1 ) * 2 > m_bucketMask + 1 )
+        grow();
+      uint32_t hash = HashString( data, length );
+      Entry *entry = lookup( data, length, hash );
+      if ( !entry->data )
+      {
+        entry->data = store( data, length );
+        entry->length = length;
+        entry->hash = hash;
+        ++m_count;
+      }
+      return entry->data;
+    }
+
+    char const *intern( char const *cstr )
+    {
+      return intern( cstr, uint32_t( strlen( cstr ) ) );
+    }
+
+    char const *intern( Variant const &stringVariant )
+    {
+      return intern( stringVariant.getStringData(), stringVariant.getStringLength() );
+    }
+
+    // returns the existing handle for a string, or 0 if it was never interned
+    char const *find( char const *data, uint32_t length ) const
+    {
+      if ( !m_entries )
+        return 0;
+      return lookup( data, length, HashString( data, length ) )->data;
+    }
+
+    char const *find( char const *cstr ) const
+    {
+      return find( cstr, uint32_t( strlen( cstr ) ) );
+    }
+
+    uint32_t getCount() const
+    {
+      return m_count;
+    }
+  };
+
+  /*
+   * C++ - Variant Dict Indices
+   */
+
+  /*!
+   * A hashed index over the string keys of a dict variant.
+   *
+   * Lookups are O(1) on average and the entries can be walked in the
+   * order the dict iterator produced them.  The index points into the
+   * dict it was built from, so it has to be rebuilt whenever that dict
+   * is modified or disposed.
+   */
+  class VariantDictIndex
+  {
+  private:
+
+    struct Entry
+    {
+      char const *keyData;
+      uint32_t keyLength;
+      uint32_t hash;
+      Variant const *value;
+    };
+
+    Entry *m_entries;
+    uint32_t m_count;
+    uint32_t m_capacity;
+    uint32_t *m_buckets;
+    uint32_t m_bucketMask;
+
+    VariantDictIndex( VariantDictIndex const & );
+    VariantDictIndex &operator =( VariantDictIndex const & );
+
+    void rehash( uint32_t bucketCount )
+    {
+      free( m_buckets );
+      m_buckets = (uint32_t *)calloc( bucketCount, sizeof(uint32_t) );
+      if ( !m_buckets )
+        Exception::Throw( "VariantDictIndex: out of memory" );
+      m_bucketMask = bucketCount - 1;
+      for ( uint32_t i=0; i<m_count; ++i )
+      {
+        uint32_t bucket = m_entries[i].hash & m_bucketMask;
+        while ( m_buckets[bucket] )
+          bucket = ( bucket + 1 ) & m_bucketMask;
+        m_buckets[bucket] = i + 1;
+      }
+    }
+
+    void append( char const *keyData, uint32_t keyLength, Variant const *value )
+    {
+      if ( m_count == m_capacity )
+      {
+        uint32_t capacity = m_capacity ? m_capacity * 2 : 16;
+        Entry *entries = (Entry *)realloc( m_entries, capacity * sizeof(Entry) );
+        if ( !entries )
+          Exception::Throw( "VariantDictIndex: out of memory" );
+        m_entries = entries;
+        m_capacity = capacity;
+      }
+      Entry &entry = m_entries[m_count++];
+      entry.keyData = keyData;
+      entry.keyLength = keyLength;
+      entry.hash = HashString( keyData, keyLength );
+      entry.value = value;
+    }
+
+  public:
+
+    VariantDictIndex()
+      : m_entries( 0 )
+      , m_count( 0 )
+      , m_capacity( 0 )
+      , m_buckets( 0 )
+      , m_bucketMask( 0 )
+    {
+    }
+
+    VariantDictIndex( Variant const &dictVariant )
+      : m_entries( 0 )
+      , m_count( 0 )
+      , m_capacity( 0 )
+      , m_buckets( 0 )
+      , m_bucketMask( 0 )
+    {
+      build( dictVariant );
+    }
+
+    ~VariantDictIndex()
+    {
+      free( m_entries );
+      free( m_buckets );
+    }
+
+    void clear()
+    {
+      m_count = 0;
+      if ( m_buckets )
+        memset( m_buckets, 0, ( m_bucketMask + 1 ) * sizeof(uint32_t) );
+    }
+
+    void build( Variant const &dictVariant )
+    {
+      clear();
+      if ( !dictVariant.isDict() )
+        return;
+      for ( Variant::DictIter it( dictVariant ); !it.isDone(); it.next() )
+      {
+        Variant const *key = it.getKey();
+        if ( key->isString() )
+          append( key->getStringData(), key->getStringLength(), it.getValue() );
+      }
+      uint32_t bucketCount = 16;
+      while ( bucketCount < m_count * 2 )
+        bucketCount *= 2;
+      rehash( bucketCount );
+    }
+
+    Variant const *find( char const *keyData, uint32_t keyLength ) const
+    {
+      if ( !m_count )
+        return 0;
+      uint32_t hash = HashString( keyData, keyLength );
+      uint32_t bucket = hash & m_bucketMask;
+      while ( uint32_t slot = m_buckets[bucket] )
+      {
+        Entry const &entry = m_entries[slot - 1];
+        if ( entry.hash == hash
+          && entry.keyLength == keyLength
+          && memcmp( entry.keyData, keyData, keyLength ) == 0 )
+          return entry.value;
+        bucket = ( bucket + 1 ) & m_bucketMask;
+      }
+      return 0;
+    }
+
+    Variant const *find( char const *keyCStr ) const
+    {
+      return find( keyCStr, uint32_t( strlen( keyCStr ) ) );
+    }
+
+    uint32_t getCount() const
+    {
+      return m_count;
+    }
+
+    char const *getKeyData( uint32_t index ) const
+    {
+      return m_entries[index].keyData;
+    }
+
+    uint32_t getKeyLength( uint32_t index ) const
+    {
+      return m_entries[index].keyLength;
+    }
+
+    Variant const *getValue( uint32_t index ) const
+    {
+      return m_entries[index].value;
+    }
+  };
+
   /*
    * C++ - KL
    */
@@ -2517,50 +2999,917 @@ namespace CreationCore
   }
   
   /*
-   * C++ - References
+   * C++ - Extension Index
    */
-  
-  class Ref
+
+  /*!
+   * Calls func for every extension named by a `require` statement of
+   * sourceCode.  Comments and string literals are skipped, and so are
+   * version constraints such as `require Math:"1.0";`.
+   */
+  inline void KLParseRequires(
+    char const *sourceCode,
+    void (*func)( void *userdata, char const *name, uint32_t length ),
+    void *userdata
+    )
   {
-  protected:
-    
-    FEC_Ref m_ref;
-    
-    void init( FEC_Ref ref )
-    {
-      m_ref = ref;
-    }
-    
-    void init( Ref const &ref )
+    char const *c = sourceCode;
+    bool statementStart = true;
+    bool inRequire = false;
+    bool expectName = false;
+    while ( *c )
     {
-      init( ref.m_ref );
-      retain();
+      if ( c[0] == '/' && c[1] == '/' )
+      {
+        while ( *c && *c != '\n' )
+          ++c;
+      }
+      else if ( c[0] == '/' && c[1] == '*' )
+      {
+        c += 2;
+        while ( *c && !( c[0] == '*' && c[1] == '/' ) )
+          ++c;
+        if ( *c )
+          c += 2;
+      }
+      else if ( *c == '"' || *c == '\'' )
+      {
+        char quote = *c++;
+        while ( *c && *c != quote )
+        {
+          if ( *c == '\\' && c[1] )
+            ++c;
+          ++c;
+        }
+        if ( *c )
+          ++c;
+        statementStart = false;
+      }
+      else if ( ( *c >= 'a' && *c <= 'z' ) || ( *c >= 'A' && *c <= 'Z' ) || *c == '_' )
+      {
+        char const *start = c;
+        while ( ( *c >= 'a' && *c <= 'z' ) || ( *c >= 'A' && *c <= 'Z' ) || ( *c >= '0' && *c <= '9' ) || *c == '_' )
+          ++c;
+        uint32_t length = uint32_t( c - start );
+        if ( inRequire && expectName )
+        {
+          func( userdata, start, length );
+          expectName = false;
+        }
+        else if ( statementStart && length == 7 && memcmp( start, "require", 7 ) == 0 )
+        {
+          inRequire = true;
+          expectName = true;
+        }
+        statementStart = false;
+      }
+      else
+      {
+        if ( *c == ';' || *c == '}' )
+        {
+          statementStart = true;
+          inRequire = false;
+        }
+        else if ( *c == ',' && inRequire )
+          expectName = true;
+        else if ( *c != ' ' && *c != '\t' && *c != '\n' && *c != '\r' )
+          statementStart = false;
+        ++c;
+      }
     }
-    
-    void set( FEC_Ref ref )
+  }
+
+  /*!
+   * An index of the KL extensions below a set of folders: each extension's
+   * manifest, the types its KL files declare and the extensions it
+   * requires.  KL files outside of any extension, as found in RT folders,
+   * are indexed as extensions of their own named after the file.
+   *
+   * addFolder() keeps the index of a folder on disk, in a file named
+   * `.fabricExtIndex` inside it or in the user's cache if the folder is
+   * read-only, and reuses that file for as long as the folder's
+   * directories, manifests and KL files keep their modification times and
+   * sizes.  Checking those takes a stat per file, where a scan
+   * also has to read and parse every manifest and KL file.
+   *
+   * getRequiredExtensions_Variant() resolves the `require` statements of a
+   * KL source through the index, including indirect requirements, so
+   * that only the extensions a program actually uses need to be loaded.
+   */
+  class ExtensionIndex
+  {
+    struct File
     {
-      release();
-      m_ref = ref;
-    }
-    
-    void set( Ref const &ref )
+      char const *path;
+      int64_t mtime;
+      int64_t size;
+      char kind;
+    };
+
+    struct Extension
     {
-      set( ref.m_ref );
-      retain();
-    }
-    
-    Ref( FEC_Ref ref )
+      char const *name;
+      char const *manifest;
+    };
+
+    struct Pair
     {
-      init( ref );
-      Exception::MaybeThrow();
-    }
-    
-  public:
-    
-    Ref()
+      uint32_t extension;
+      char const *name;
+    };
+
+    // maps names interned in m_strings to indices, probed by pointer
+    class HandleTable
     {
-      init( FEC_NULL_REF );
-    }
+      char const **m_keys;
+      uint32_t *m_values;
+      uint32_t m_mask;
+      uint32_t m_count;
+
+      HandleTable( HandleTable const & );
+      HandleTable &operator =( HandleTable const & );
+
+      static uint32_t Hash( char const *key )
+      {
+        return uint32_t( ( uintptr_t( key ) >> 3 ) * 2654435761u );
+      }
+
+      void grow()
+      {
+        uint32_t capacity = m_keys ? ( m_mask + 1 ) * 2 : 64;
+        char const **keys = (char const **)calloc( capacity, sizeof(char const *) );
+        uint32_t *values = (uint32_t *)malloc( capacity * sizeof(uint32_t) );
+        if ( !keys || !values )
+        {
+          free( keys );
+          free( values );
+          Exception::Throw( "ExtensionIndex: out of memory" );
+        }
+        for ( uint32_t i=0; m_keys && i<=m_mask; ++i )
+        {
+          if ( !m_keys[i] )
+            continue;
+          uint32_t index = Hash( m_keys[i] ) & ( capacity - 1 );
+          while ( keys[index] )
+            index = ( index + 1 ) & ( capacity - 1 );
+          keys[index] = m_keys[i];
+          values[index] = m_values[i];
+        }
+        free( m_keys );
+        free( m_values );
+        m_keys = keys;
+        m_values = values;
+        m_mask = capacity - 1;
+      }
+
+    public:
+
+      HandleTable()
+        : m_keys( 0 )
+        , m_values( 0 )
+        , m_mask( 0 )
+        , m_count( 0 )
+      {
+      }
+
+      ~HandleTable()
+      {
+        free( m_keys );
+        free( m_values );
+      }
+
+      int32_t find( char const *key ) const
+      {
+        if ( !m_keys || !key )
+          return -1;
+        uint32_t index = Hash( key ) & m_mask;
+        while ( m_keys[index] )
+        {
+          if ( m_keys[index] == key )
+            return int32_t( m_values[index] );
+          index = ( index + 1 ) & m_mask;
+        }
+        return -1;
+      }
+
+      // keeps the value of a key that is already present
+      void insert( char const *key, uint32_t value )
+      {
+        if ( find( key ) >= 0 )
+          return;
+        if ( !m_keys || ( m_count + 1 ) * 2 > m_mask + 1 )
+          grow();
+        uint32_t index = Hash( key ) & m_mask;
+        while ( m_keys[index] )
+          index = ( index + 1 ) & m_mask;
+        m_keys[index] = key;
+        m_values[index] = value;
+        ++m_count;
+      }
+    };
+
+    StringPool m_strings;
+    Extension *m_extensions;
+    uint32_t m_extensionCount;
+    Pair *m_types;
+    uint32_t m_typeCount;
+    // the first extension with a name, and the first declaring a type
+    HandleTable m_extensionsByName;
+    HandleTable m_extensionsByType;
+    Pair *m_requires;
+    uint32_t m_requireCount;
+    uint32_t m_scannedFolderCount;
+    uint32_t m_cachedFolderCount;
+
+    ExtensionIndex( ExtensionIndex const & );
+    ExtensionIndex &operator =( ExtensionIndex const & );
+
+    static bool Stat( char const *path, int64_t &mtime, int64_t &size )
+    {
+#if !defined(_WIN32)
+      struct stat info;
+      if ( stat( path, &info ) != 0 )
+        return false;
+      mtime = int64_t( info.st_mtime );
+      size = S_ISDIR( info.st_mode ) ? -1 : int64_t( info.st_size );
+      return true;
+#else
+      (void)path;
+      (void)mtime;
+      (void)size;
+      return false;
+#endif
+    }
+
+    static char *ReadFile( char const *path, uint32_t *length )
+    {
+      FILE *file = fopen( path, "rb" );
+      if ( !file )
+        return 0;
+      fseek( file, 0, SEEK_END );
+      long size = ftell( file );
+      fseek( file, 0, SEEK_SET );
+      if ( size < 0 )
+      {
+        fclose( file );
+        return 0;
+      }
+      char *data = (char *)malloc( size_t( size ) + 1 );
+      size_t read = fread( data, 1, size_t( size ), file );
+      data[read] = '\0';
+      fclose( file );
+      if ( length )
+        *length = uint32_t( read );
+      return data;
+    }
+
+    static bool EndsWith( char const *str, char const *suffix )
+    {
+      size_t strLength = strlen( str );
+      size_t suffixLength = strlen( suffix );
+      return strLength >= suffixLength && strcmp( str + strLength - suffixLength, suffix ) == 0;
+    }
+
+    char const *join( char const *directory, char const *name )
+    {
+      size_t directoryLength = strlen( directory );
+      size_t nameLength = strlen( name );
+      char *path = (char *)malloc( directoryLength + nameLength + 2 );
+      memcpy( path, directory, directoryLength );
+      path[directoryLength] = '/';
+      memcpy( path + directoryLength + 1, name, nameLength + 1 );
+      char const *result = m_strings.intern( path );
+      free( path );
+      return result;
+    }
+
+    static void AppendFile( File **files, uint32_t *count, char const *path, char kind )
+    {
+      File file;
+      file.path = path;
+      file.kind = kind;
+      if ( !Stat( path, file.mtime, file.size ) )
+        return;
+      *files = (File *)realloc( *files, ( *count + 1 ) * sizeof(File) );
+      (*files)[(*count)++] = file;
+    }
+
+    void walk( char const *directory, uint32_t depth, File **files, uint32_t *count )
+    {
+#if !defined(_WIN32)
+      AppendFile( files, count, directory, 'D' );
+      DIR *dir = opendir( directory );
+      if ( !dir )
+        return;
+      while ( struct dirent *entry = readdir( dir ) )
+      {
+        if ( entry->d_name[0] == '.' )
+          continue;
+        char const *path = join( directory, entry->d_name );
+        if ( EndsWith( entry->d_name, ".fpm.json" ) )
+          AppendFile( files, count, path, 'M' );
+        else if ( EndsWith( entry->d_name, ".kl" ) )
+          AppendFile( files, count, path, 'K' );
+        else if ( depth < 8 )
+        {
+          int64_t mtime, size;
+          if ( Stat( path, mtime, size ) && size < 0 )
+            walk( path, depth + 1, files, count );
+        }
+      }
+      closedir( dir );
+#else
+      (void)directory;
+      (void)depth;
+      (void)files;
+      (void)count;
+#endif
+    }
+
+    uint32_t addExtension( char const *name, char const *manifest )
+    {
+      Extension extension;
+      extension.name = m_strings.intern( name );
+      extension.manifest = m_strings.intern( manifest );
+      m_extensions = (Extension *)realloc( m_extensions, ( m_extensionCount + 1 ) * sizeof(Extension) );
+      m_extensions[m_extensionCount] = extension;
+      m_extensionsByName.insert( extension.name, m_extensionCount );
+      return m_extensionCount++;
+    }
+
+    static void AppendPair( Pair **pairs, uint32_t *count, uint32_t extension, char const *name )
+    {
+      for ( uint32_t i=0; i<*count; ++i )
+      {
+        if ( (*pairs)[i].extension == extension && (*pairs)[i].name == name )
+          return;
+      }
+      Pair pair;
+      pair.extension = extension;
+      pair.name = name;
+      *pairs = (Pair *)realloc( *pairs, ( *count + 1 ) * sizeof(Pair) );
+      (*pairs)[(*count)++] = pair;
+    }
+
+    void addType( uint32_t extension, char const *name )
+    {
+      AppendPair( &m_types, &m_typeCount, extension, name );
+      m_extensionsByType.insert( name, extension );
+    }
+
+    struct Parse
+    {
+      ExtensionIndex *index;
+      uint32_t extension;
+    };
+
+    static void AddRequire( void *userdata, char const *name, uint32_t length )
+    {
+      Parse &parse = *static_cast<Parse *>( userdata );
+      ExtensionIndex &index = *parse.index;
+      AppendPair( &index.m_requires, &index.m_requireCount, parse.extension, index.m_strings.intern( name, length ) );
+    }
+
+    /// records the types declared by a KL file: struct, object and interface
+    void parseTypes( uint32_t extension, char const *source )
+    {
+      static char const *keywords[] = { "struct", "object", "interface" };
+      char const *c = source;
+      while ( *c )
+      {
+        if ( c[0] == '/' && c[1] == '/' )
+        {
+          while ( *c && *c != '\n' )
+            ++c;
+          continue;
+        }
+        if ( c[0] == '/' && c[1] == '*' )
+        {
+          c += 2;
+          while ( *c && !( c[0] == '*' && c[1] == '/' ) )
+            ++c;
+          if ( *c )
+            c += 2;
+          continue;
+        }
+        if ( !( ( *c >= 'a' && *c <= 'z' ) || ( *c >= 'A' && *c <= 'Z' ) || *c == '_' ) )
+        {
+          ++c;
+          continue;
+        }
+        char const *start = c;
+        while ( ( *c >= 'a' && *c <= 'z' ) || ( *c >= 'A' && *c <= 'Z' ) || ( *c >= '0' && *c <= '9' ) || *c == '_' )
+          ++c;
+        for ( uint32_t i=0; i<3; ++i )
+        {
+          size_t length = strlen( keywords[i] );
+          if ( size_t( c - start ) != length || memcmp( start, keywords[i], length ) != 0 )
+            continue;
+          while ( *c == ' ' || *c == '\t' || *c == '\n' || *c == '\r' )
+            ++c;
+          char const *name = c;
+          while ( ( *c >= 'a' && *c <= 'z' ) || ( *c >= 'A' && *c <= 'Z' ) || ( *c >= '0' && *c <= '9' ) || *c == '_' )
+            ++c;
+          if ( c > name )
+            addType( extension, m_strings.intern( name, uint32_t( c - name ) ) );
+          break;
+        }
+      }
+    }
+
+    void scanManifest( char const *manifest, StringPool &codeFiles )
+    {
+      char const *slash = strrchr( manifest, '/' );
+      char const *fileName = slash ? slash + 1 : manifest;
+      SmallString name( fileName, uint32_t( strlen( fileName ) - strlen( ".fpm.json" ) ) );
+      SmallString directory( manifest, uint32_t( slash ? slash - manifest : 0 ) );
+      uint32_t extension = addExtension( name.getCString(), manifest );
+
+      uint32_t length = 0;
+      char *json = ReadFile( manifest, &length );
+      if ( !json )
+        return;
+      Variant variant;
+      try
+      {
+        variant = Variant::CreateFromJSON( json, length );
+      }
+      catch ( Exception const & )
+      {
+      }
+      free( json );
+
+      Parse parse;
+      parse.index = this;
+      parse.extension = extension;
+      Variant const *requirements = variant.isDict() ? variant.getDictValue( "requires" ) : 0;
+      if ( requirements && requirements->isDict() )
+      {
+        for ( Variant::DictIter it( *requirements ); !it.isDone(); it.next() )
+          AddRequire( &parse, it.getKey()->getStringData(), it.getKey()->getStringLength() );
+      }
+
+      Variant const *code = variant.isDict() ? variant.getDictValue( "code" ) : 0;
+      if ( !code )
+        return;
+      Variant const *single = code;
+      uint32_t count = code->isArray() ? code->getArraySize() : 1;
+      for ( uint32_t i=0; i<count; ++i )
+      {
+        Variant const *file = code->isArray() ? code->getArrayElement( i ) : single;
+        if ( !file->isString() )
+          continue;
+        char const *path = directory.isEmpty() ? file->getString_cstr() : join( directory.getCString(), file->getString_cstr() );
+        codeFiles.intern( path );
+        char *source = ReadFile( path, 0 );
+        if ( !source )
+          continue;
+        KLParseRequires( source, &AddRequire, &parse );
+        parseTypes( extension, source );
+        free( source );
+      }
+    }
+
+    static char *IndexPath( char const *folder )
+    {
+      size_t length = strlen( folder );
+      char *path = (char *)malloc( length + sizeof("/.fabricExtIndex") );
+      memcpy( path, folder, length );
+      memcpy( path + length, "/.fabricExtIndex", sizeof("/.fabricExtIndex") );
+      return path;
+    }
+
+    /// the index of a folder that can't be written to is kept in the user's
+    /// cache instead: $FABRIC_EXT_INDEX_CACHE, $XDG_CACHE_HOME/fabric or
+    /// ~/.cache/fabric, in a file named after a hash of the folder's path
+    static char *CachePath( char const *folder, bool create )
+    {
+#if !defined(_WIN32)
+      char const *directory = getenv( "FABRIC_EXT_INDEX_CACHE" );
+      char const *suffix = "";
+      if ( !directory || !*directory )
+      {
+        directory = getenv( "XDG_CACHE_HOME" );
+        suffix = "/fabric";
+      }
+      if ( !directory || !*directory )
+      {
+        directory = getenv( "HOME" );
+        suffix = "/.cache/fabric";
+      }
+      if ( !directory || !*directory )
+        return 0;
+      char name[32];
+      sprintf( name, "/extIndex-%08x", unsigned( HashString( folder ) ) );
+      size_t directoryLength = strlen( directory );
+      size_t suffixLength = strlen( suffix );
+      char *path = (char *)malloc( directoryLength + suffixLength + strlen( name ) + 1 );
+      memcpy( path, directory, directoryLength );
+      memcpy( path + directoryLength, suffix, suffixLength + 1 );
+      if ( create )
+      {
+        for ( char *slash = strchr( path + 1, '/' ); ; slash = strchr( slash + 1, '/' ) )
+        {
+          if ( slash )
+            *slash = '\0';
+          mkdir( path, 0755 );
+          if ( !slash )
+            break;
+          *slash = '/';
+        }
+      }
+      strcat( path, name );
+      return path;
+#else
+      (void)folder;
+      (void)create;
+      return 0;
+#endif
+    }
+
+    /// reads the index file at path if it belongs to folder, is complete
+    /// and every file it lists is unchanged.  Only adds its extensions if
+    /// apply is true
+    bool readIndex( char const *folder, char const *path, bool apply )
+    {
+      char *data = ReadFile( path, 0 );
+      if ( !data )
+        return false;
+
+      // an index cut short by a crash lacks the end marker
+      size_t length = strlen( data );
+      bool valid = length >= 14 && strncmp( data, "FEXTIDX 2\n", 10 ) == 0
+        && data[length - 5] == '\n' && strcmp( data + length - 4, "END\n" ) == 0;
+      if ( valid )
+        data[length - 4] = '\0';
+      bool ownFolder = false;
+      for ( char *line = data + 10; valid && *line; )
+      {
+        char *end = strchr( line, '\n' );
+        if ( !end )
+          break;
+        *end = '\0';
+        if ( line[0] == 'F' )
+        {
+          ownFolder = strcmp( line + 2, folder ) == 0;
+          valid = ownFolder;
+        }
+        else if ( line[0] == 'D' || line[0] == 'M' || line[0] == 'K' )
+        {
+          long long mtime, size;
+          int offset = 0;
+          int64_t currentMTime, currentSize;
+          valid = sscanf( line + 2, "%lld %lld %n", &mtime, &size, &offset ) == 2 && offset > 0
+            && Stat( line + 2 + offset, currentMTime, currentSize )
+            && currentMTime == int64_t( mtime ) && currentSize == int64_t( size );
+        }
+        line = end + 1;
+      }
+      if ( !valid || !ownFolder || !apply )
+      {
+        free( data );
+        return valid && ownFolder;
+      }
+
+      uint32_t base = m_extensionCount;
+      for ( char *line = data + 10; *line; line += strlen( line ) + 1 )
+      {
+        char *space = strchr( line + 2, ' ' );
+        if ( line[0] == 'E' && space )
+        {
+          *space = '\0';
+          addExtension( line + 2, space + 1 );
+        }
+        else if ( ( line[0] == 'T' || line[0] == 'Q' ) && space )
+        {
+          uint32_t extension = base + uint32_t( strtoul( line + 2, 0, 10 ) );
+          if ( extension >= m_extensionCount )
+            continue;
+          char const *name = m_strings.intern( space + 1 );
+          if ( line[0] == 'T' )
+            addType( extension, name );
+          else
+            AppendPair( &m_requires, &m_requireCount, extension, name );
+        }
+      }
+      free( data );
+      return true;
+    }
+
+    /// reads the folder's index file, or the one in the user's cache
+    bool load( char const *folder )
+    {
+      char *indexPath = IndexPath( folder );
+      bool result = readIndex( folder, indexPath, true );
+      free( indexPath );
+      if ( result )
+        return true;
+      char *cachePath = CachePath( folder, false );
+      result = cachePath && readIndex( folder, cachePath, true );
+      free( cachePath );
+      return result;
+    }
+
+    /// writes the index to a temporary file which is then renamed to path,
+    /// so that readers never see a partially written index.  The temporary
+    /// file has a unique name, since other processes may index the same
+    /// folder at the same time
+    bool writeIndex( char const *path, char const *folder, File const *files, uint32_t fileCount, uint32_t base ) const
+    {
+      size_t pathLength = strlen( path );
+      char *tempPath = (char *)malloc( pathLength + sizeof(".XXXXXX") );
+      if ( !tempPath )
+        return false;
+      memcpy( tempPath, path, pathLength );
+#if !defined(_WIN32)
+      memcpy( tempPath + pathLength, ".XXXXXX", sizeof(".XXXXXX") );
+      int fd = mkstemp( tempPath );
+      FILE *file = 0;
+      if ( fd >= 0 && ( fchmod( fd, 0644 ) != 0 || !( file = fdopen( fd, "wb" ) ) ) )
+      {
+        ::close( fd );
+        remove( tempPath );
+      }
+#else
+      memcpy( tempPath + pathLength, ".tmp", sizeof(".tmp") );
+      FILE *file = fopen( tempPath, "wb" );
+#endif
+      if ( !file )
+      {
+        free( tempPath );
+        return false;
+      }
+      fputs( "FEXTIDX 2\n", file );
+      fprintf( file, "F %s\n", folder );
+      for ( uint32_t i=0; i<fileCount; ++i )
+      {
+        // creating the index file changed the folder's modification time
+        int64_t mtime = files[i].mtime, size = files[i].size;
+        if ( files[i].kind == 'D' )
+          Stat( files[i].path, mtime, size );
+        fprintf( file, "%c %lld %lld %s\n", files[i].kind, (long long)mtime, (long long)size, files[i].path );
+      }
+      for ( uint32_t i=base; i<m_extensionCount; ++i )
+        fprintf( file, "E %s %s\n", m_extensions[i].name, m_extensions[i].manifest );
+      for ( uint32_t i=0; i<m_typeCount; ++i )
+      {
+        if ( m_types[i].extension >= base )
+          fprintf( file, "T %u %s\n", unsigned( m_types[i].extension - base ), m_types[i].name );
+      }
+      for ( uint32_t i=0; i<m_requireCount; ++i )
+      {
+        if ( m_requires[i].extension >= base )
+          fprintf( file, "Q %u %s\n", unsigned( m_requires[i].extension - base ), m_requires[i].name );
+      }
+      fputs( "END\n", file );
+      bool failed = fflush( file ) != 0 || ferror( file ) != 0;
+#if !defined(_WIN32)
+      if ( !failed && fsync( fileno( file ) ) != 0 )
+        failed = true;
+#endif
+      if ( fclose( file ) != 0 )
+        failed = true;
+      if ( failed || rename( tempPath, path ) != 0 )
+      {
+        remove( tempPath );
+        free( tempPath );
+        return false;
+      }
+      free( tempPath );
+      return true;
+    }
+
+    /// writes the index into the folder, or into the user's cache if the
+    /// folder can't be written to
+    void save( char const *folder, File const *files, uint32_t fileCount, uint32_t base )
+    {
+      char *indexPath = IndexPath( folder );
+      // the rename changes the folder's modification time once more, after
+      // the index recorded it, so the index is rewritten until it is current
+      bool written = false;
+      for ( uint32_t attempt=0; attempt<3; ++attempt )
+      {
+        written = writeIndex( indexPath, folder, files, fileCount, base );
+        if ( !written || readIndex( folder, indexPath, false ) )
+          break;
+      }
+      free( indexPath );
+      if ( written )
+        return;
+      char *cachePath = CachePath( folder, true );
+      if ( cachePath )
+        writeIndex( cachePath, folder, files, fileCount, base );
+      free( cachePath );
+    }
+
+    struct Closure
+    {
+      ExtensionIndex const *index;
+      StringPool seen;
+      Variant result;
+    };
+
+    static void AddRequired( void *userdata, char const *name, uint32_t length )
+    {
+      Closure &closure = *static_cast<Closure *>( userdata );
+      if ( closure.seen.find( name, length ) )
+        return;
+      char const *handle = closure.seen.intern( name, length );
+      closure.result.arrayAppend( Variant::CreateString( name, length ) );
+      int32_t extension = closure.index->findExtension( handle );
+      if ( extension < 0 )
+        return;
+      for ( uint32_t i=0; i<closure.index->m_requireCount; ++i )
+      {
+        Pair const &require = closure.index->m_requires[i];
+        if ( require.extension == uint32_t( extension ) )
+          AddRequired( userdata, require.name, uint32_t( strlen( require.name ) ) );
+      }
+    }
+
+  public:
+
+    ExtensionIndex()
+      : m_extensions( 0 )
+      , m_extensionCount( 0 )
+      , m_types( 0 )
+      , m_typeCount( 0 )
+      , m_requires( 0 )
+      , m_requireCount( 0 )
+      , m_scannedFolderCount( 0 )
+      , m_cachedFolderCount( 0 )
+    {
+    }
+
+    ~ExtensionIndex()
+    {
+      free( m_extensions );
+      free( m_types );
+      free( m_requires );
+    }
+
+    /*!
+     * Adds the extensions below folder, from the folder's index file when
+     * it is current and by scanning the folder otherwise.  A scan rewrites
+     * the index file, in the user's cache if the folder isn't writable.
+     * Returns false if the folder can't be read.
+     */
+    bool addFolder( char const *folder )
+    {
+      int64_t mtime, size;
+      if ( !Stat( folder, mtime, size ) || size >= 0 )
+        return false;
+      if ( load( folder ) )
+      {
+        ++m_cachedFolderCount;
+        return true;
+      }
+
+      File *files = 0;
+      uint32_t fileCount = 0;
+      walk( m_strings.intern( folder ), 0, &files, &fileCount );
+      uint32_t base = m_extensionCount;
+      StringPool code;
+      for ( uint32_t i=0; i<fileCount; ++i )
+      {
+        if ( files[i].kind == 'M' )
+          scanManifest( files[i].path, code );
+      }
+      // KL files outside of any extension, as found in RT folders, are
+      // indexed as extensions of their own named after the file
+      for ( uint32_t i=0; i<fileCount; ++i )
+      {
+        if ( files[i].kind != 'K' || code.find( files[i].path ) )
+          continue;
+        char const *slash = strrchr( files[i].path, '/' );
+        char const *fileName = slash ? slash + 1 : files[i].path;
+        SmallString name( fileName, uint32_t( strlen( fileName ) - 3 ) );
+        char *source = ReadFile( files[i].path, 0 );
+        if ( !source )
+          continue;
+        uint32_t extension = addExtension( name.getCString(), files[i].path );
+        Parse parse;
+        parse.index = this;
+        parse.extension = extension;
+        KLParseRequires( source, &AddRequire, &parse );
+        parseTypes( extension, source );
+        free( source );
+      }
+      save( folder, files, fileCount, base );
+      free( files );
+      ++m_scannedFolderCount;
+      return true;
+    }
+
+    uint32_t getExtensionCount() const
+    {
+      return m_extensionCount;
+    }
+
+    char const *getExtensionName( uint32_t index ) const
+    {
+      return m_extensions[index].name;
+    }
+
+    char const *getExtensionManifest( uint32_t index ) const
+    {
+      return m_extensions[index].manifest;
+    }
+
+    /// returns the index of the extension, or -1 if it isn't indexed
+    int32_t findExtension( char const *name, uint32_t length ) const
+    {
+      return m_extensionsByName.find( m_strings.find( name, length ) );
+    }
+
+    int32_t findExtension( char const *name ) const
+    {
+      return m_extensionsByName.find( m_strings.find( name ) );
+    }
+
+    /// returns the index of the extension declaring type, or -1
+    int32_t findExtensionProvidingType( char const *type, uint32_t length ) const
+    {
+      return m_extensionsByType.find( m_strings.find( type, length ) );
+    }
+
+    int32_t findExtensionProvidingType( char const *type ) const
+    {
+      return m_extensionsByType.find( m_strings.find( type ) );
+    }
+
+    /*!
+     * Returns the names of the extensions required by sourceCode, directly
+     * or through other extensions, as an array of strings.  Extensions
+     * which aren't indexed are included, without their requirements.
+     */
+    Variant getRequiredExtensions_Variant( char const *sourceCode ) const
+    {
+      Closure closure;
+      closure.index = this;
+      closure.result = Variant::CreateArray();
+      KLParseRequires( sourceCode, &AddRequired, &closure );
+      return closure.result;
+    }
+
+    /// returns the number of folders scanned rather than read from an index file
+    uint32_t getScannedFolderCount() const
+    {
+      return m_scannedFolderCount;
+    }
+
+    /// returns the number of folders read from a current index file
+    uint32_t getCachedFolderCount() const
+    {
+      return m_cachedFolderCount;
+    }
+  };
+
+  /*
+   * C++ - References
+   */
+  
+  class Ref
+  {
+  protected:
+    
+    FEC_Ref m_ref;
+    
+    void init( FEC_Ref ref )
+    {
+      m_ref = ref;
+    }
+    
+    void init( Ref const &ref )
+    {
+      init( ref.m_ref );
+      retain();
+    }
+    
+    void set( FEC_Ref ref )
+    {
+      release();
+      m_ref = ref;
+    }
+    
+    void set( Ref const &ref )
+    {
+      set( ref.m_ref );
+      retain();
+    }
+    
+    Ref( FEC_Ref ref )
+    {
+      init( ref );
+      Exception::MaybeThrow();
+    }
+    
+  public:
+    
+    Ref()
+    {
+      init( FEC_NULL_REF );
+    }
     
     Ref( Ref const &that )
     {
@@ -2657,6 +4006,9 @@ There is also an :ref:`CAPI.clients.api-reference-c`.
   static const uint32_t ClientOptimizationType_Synchronous = FEC_ClientOptimizationType_Synchronous;
   static const uint32_t ClientOptimizationType_None = FEC_ClientOptimizationType_None;
 
+  inline void BumpRTGeneration();
+  inline uint64_t RTGeneration();
+
   class Client : public Ref
   {
     friend class DGBinding;
@@ -2746,14 +4098,7 @@ There is also an :ref:`CAPI.clients.api-reference-c`.
       return contextID;
     }
 
-    Variant getMemoryUsage_Variant()
-    {
-      FEC_Variant result = FEC_ClientGetMemoryUsage_Variant(
-        getCRef()
-        );
-      Exception::MaybeThrow();
-      return Variant( &result );
-    }
+    Variant getMemoryUsage_Variant();
 
     void startInstrumentation()
     {
@@ -2794,6 +4139,7 @@ There is also an :ref:`CAPI.clients.api-reference-c`.
         getCRef(),
         extNameCString
         );
+      BumpRTGeneration();
       Exception::MaybeThrow();
     }
 
@@ -2893,7 +4239,7 @@ There is also an :ref:`CAPI.clients.api-reference-c`.
    */
   
   typedef FEC_RTStructMemberInfo RTStructMemberInfo;
-  
+
   inline void RegisterStruct(
     Client const &client,
     char const *nameCString,
@@ -2911,6 +4257,7 @@ There is also an :ref:`CAPI.clients.api-reference-c`.
       klBindingsFilename,
       klBindingsSourceCode
       );
+    BumpRTGeneration();
     Exception::MaybeThrow();
   }
   
@@ -2931,6 +4278,7 @@ There is also an :ref:`CAPI.clients.api-reference-c`.
       klBindingsFilename,
       klBindingsSourceCode
       );
+    BumpRTGeneration();
     Exception::MaybeThrow();
   }
   
@@ -2971,1269 +4319,6343 @@ There is also an :ref:`CAPI.clients.api-reference-c`.
     return result;
   }
 
-  /*
-   * C++ - DG
+  /*!
+   * A cache of RT layouts with integer type IDs.
+   *
+   * getTypeID() resolves a type name once; after that, size, alignment,
+   * shallowness and member offsets are array lookups.  The runtime
+   * reports sizes and shallowness only, so alignment and member offsets
+   * are derived from the members in GetRegisteredTypes_Variant() using
+   * the usual C layout rules, the first time any of them is asked for.
+   * They are only reported (hasMemberLayout()) when the derived size
+   * matches the runtime's, which excludes objects.
+   *
+   * Type IDs stay valid for the lifetime of the cache.  The layouts are
+   * refreshed lazily once RTGeneration() changes, which RegisterStruct(),
+   * RegisterObject(), Client::loadExtension() and DGOperator::setSourceCode()
+   * bump.
    */
-  
-  class DGCompiledObject : public Ref
+  class RTTypeCache
   {
-  protected:
-    
-    DGCompiledObject( FEC_DGCompiledObjectRef that )
-      : Ref( that )
-    {
-    }
-    
   public:
-    
-    DGCompiledObject()
+
+    typedef uint32_t TypeID;
+    static const TypeID InvalidTypeID = 0xffffffffu;
+
+  private:
+
+    struct Member
     {
+      char const *name;
+      TypeID type;
+      uint32_t offset;
+    };
+
+    struct Descriptor
+    {
+      char const *name;
+      uint32_t hash;
+      uint64_t generation;
+      uint64_t layoutGeneration;
+      uint32_t size;
+      uint32_t alignment;
+      Member *members;
+      uint32_t memberCount;
+      bool shallow;
+      bool layout;
+      bool resolving;
+    };
+
+    Client m_client;
+    StringPool m_names;
+    Descriptor *m_descriptors;
+    uint32_t m_count;
+    uint32_t *m_buckets;
+    uint32_t m_bucketMask;
+    Variant m_types;
+    VariantDictIndex m_typeIndex;
+    uint64_t m_typesGeneration;
+
+    RTTypeCache( RTTypeCache const & );
+    RTTypeCache &operator =( RTTypeCache const & );
+
+    void rehash()
+    {
+      uint32_t bucketCount = m_bucketMask ? ( m_bucketMask + 1 ) * 2 : 64;
+      free( m_buckets );
+      m_buckets = (uint32_t *)calloc( bucketCount, sizeof(uint32_t) );
+      m_bucketMask = bucketCount - 1;
+      for ( uint32_t i=0; i<m_count; ++i )
+      {
+        uint32_t bucket = m_descriptors[i].hash & m_bucketMask;
+        while ( m_buckets[bucket] )
+          bucket = ( bucket + 1 ) & m_bucketMask;
+        m_buckets[bucket] = i + 1;
+      }
     }
-    
-    DGCompiledObject( DGCompiledObject const &that )
-      : Ref( that )
+
+    static uint32_t NaturalAlignment( uint32_t size )
     {
+      uint32_t alignment = 1;
+      while ( alignment < 8 && alignment * 2 <= size && size % ( alignment * 2 ) == 0 )
+        alignment *= 2;
+      return alignment;
     }
-    
-    DGCompiledObject &operator =( DGCompiledObject const &that )
+
+    static uint32_t AlignUp( uint32_t offset, uint32_t alignment )
     {
-      set( that );
-      return *this;
+      return ( offset + alignment - 1 ) / alignment * alignment;
     }
-    
-    Variant getErrors()
+
+    /// reads a member from either an array of {"name", "type"} dicts or
+    /// of single entry {name: type} dicts
+    static bool GetMember( Variant const &members, uint32_t index, char const *&name, char const *&type )
     {
-      FEC_DGCompiledObjectPrepareForExecution( getCRef() );
-      Exception::MaybeThrow();
+      Variant const *member = members.getArrayElement( index );
+      if ( !member->isDict() )
+        return false;
+      Variant const *memberName = member->getDictValue( "name" );
+      Variant const *memberType = member->getDictValue( "type" );
+      if ( memberName && memberType && memberName->isString() && memberType->isString() )
+      {
+        name = memberName->getString_cstr();
+        type = memberType->getString_cstr();
+        return true;
+      }
+      Variant::DictIter it( *member );
+      if ( it.isDone() || !it.getValue()->isString() )
+        return false;
+      name = it.getKey()->getString_cstr();
+      type = it.getValue()->getString_cstr();
+      return true;
+    }
+
+    /// queries the size and shallowness of a type; the layout is derived
+    /// from them when it is first asked for
+    void refresh( TypeID id )
+    {
+      Descriptor &descriptor = m_descriptors[id];
+      descriptor.generation = RTGeneration();
+      descriptor.size = GetRegisteredTypeSize( m_client, descriptor.name );
+      descriptor.shallow = GetRegisteredTypeIsShallow( m_client, descriptor.name );
+      descriptor.alignment = descriptor.shallow ? NaturalAlignment( descriptor.size ) : NaturalAlignment( sizeof(void *) );
+      descriptor.layoutGeneration = 0;
+      descriptor.layout = false;
+    }
+
+    /// derives the alignment and member offsets of a type, replacing the
+    /// members of its previous layout
+    void refreshLayout( TypeID id )
+    {
+      uint64_t generation = RTGeneration();
+      m_descriptors[id].layoutGeneration = generation;
+      m_descriptors[id].resolving = true;
+
+      Member *layoutMembers = 0;
+      uint32_t count = 0;
+      bool layout = false;
+      uint32_t offset = 0;
+      uint32_t alignment = 1;
+      try
+      {
+        if ( m_typesGeneration != generation )
+        {
+          m_types = GetRegisteredTypes_Variant( m_client );
+          m_typeIndex.build( m_types );
+          m_typesGeneration = generation;
+        }
+        Variant const *description = m_typeIndex.find( m_descriptors[id].name );
+        Variant const *members = description && description->isDict() ? description->getDictValue( "members" ) : 0;
+
+        Variant memberList;
+        if ( members && members->isDict() )
+        {
+          memberList = Variant::CreateArray();
+          for ( Variant::DictIter it( *members ); !it.isDone(); it.next() )
+          {
+            Variant entry = Variant::CreateDict();
+            entry.setDictValue( *it.getKey(), *it.getValue() );
+            memberList.arrayAppend( entry );
+          }
+          members = &memberList;
+        }
+
+        if ( members && members->isArray() && members->getArraySize() > 0 )
+        {
+          count = members->getArraySize();
+          layoutMembers = (Member *)malloc( count * sizeof(Member) );
+          if ( !layoutMembers )
+            Exception::Throw( "RTTypeCache: out of memory" );
+          layout = true;
+          for ( uint32_t i=0; i<count; ++i )
+          {
+            char const *name = "";
+            char const *type = "";
+            if ( !GetMember( *members, i, name, type ) )
+              layout = false;
+            // resolving the member type may grow m_descriptors, so no
+            // references into it are held across it
+            TypeID memberType = getTypeID( type );
+            uint32_t memberOffset = 0;
+            if ( memberType == InvalidTypeID || m_descriptors[memberType].resolving )
+              layout = false;
+            else
+            {
+              uint32_t memberAlignment = getAlignment( memberType );
+              offset = AlignUp( offset, memberAlignment );
+              memberOffset = offset;
+              offset += getSize( memberType );
+              if ( memberAlignment > alignment )
+                alignment = memberAlignment;
+            }
+            layoutMembers[i].name = m_names.intern( name );
+            layoutMembers[i].type = memberType;
+            layoutMembers[i].offset = memberOffset;
+          }
+        }
+      }
+      catch ( Exception const & )
+      {
+        free( layoutMembers );
+        m_descriptors[id].layoutGeneration = 0;
+        m_descriptors[id].resolving = false;
+        throw;
+      }
 
-      FEC_Variant result = FEC_DGCompiledObjectGetErrors_Variant( getCRef() );
-      Exception::MaybeThrow();
-      return Variant( &result );
+      Descriptor &descriptor = m_descriptors[id];
+      free( descriptor.members );
+      descriptor.members = layoutMembers;
+      descriptor.memberCount = count;
+      if ( layout && AlignUp( offset, alignment ) == descriptor.size )
+      {
+        descriptor.layout = true;
+        descriptor.alignment = alignment;
+      }
+      descriptor.resolving = false;
     }
-  };
-  
-  class DGOperator;
-  
-  class DGBinding : public DGCompiledObject
-  {
-    friend class DGBindingList;
 
-  protected:
-    
-    DGBinding( FEC_DGBindingRef dgBindingRef )
-      : DGCompiledObject( dgBindingRef )
+    Descriptor &get( TypeID id )
     {
+      if ( id >= m_count )
+        Exception::Throw( "RTTypeCache: invalid type ID" );
+      if ( m_descriptors[id].generation != RTGeneration() )
+        refresh( id );
+      return m_descriptors[id];
     }
-    
+
+    Descriptor &getLayout( TypeID id )
+    {
+      get( id );
+      if ( m_descriptors[id].layoutGeneration != RTGeneration() && !m_descriptors[id].resolving )
+        refreshLayout( id );
+      return m_descriptors[id];
+    }
+
   public:
-    
-    DGBinding()
+
+    RTTypeCache( Client const &client )
+      : m_client( client )
+      , m_descriptors( 0 )
+      , m_count( 0 )
+      , m_buckets( 0 )
+      , m_bucketMask( 0 )
+      , m_typesGeneration( 0 )
     {
     }
-    
-    DGBinding( Client const &client )
-      : DGCompiledObject( FEC_DGBindingCreateEmpty( client.getCRef() ) )
+
+    ~RTTypeCache()
     {
+      for ( uint32_t i=0; i<m_count; ++i )
+        free( m_descriptors[i].members );
+      free( m_descriptors );
+      free( m_buckets );
     }
-    
-    DGBinding(
-      DGOperator const &dgOperator,
-      uint32_t parameterCount,
-      char const **parameters
-      );
-    
-    DGBinding( DGBinding const &that )
-      : DGCompiledObject( that )
+
+    Client const &getClient() const
     {
+      return m_client;
     }
-    
-    DGBinding &operator =( DGBinding const &that )
+
+    /// returns the ID of a type, or InvalidTypeID if the type isn't registered
+    TypeID getTypeID( char const *name )
     {
-      set( that );
-      return *this;
+      uint32_t length = uint32_t( strlen( name ) );
+      uint32_t hash = HashString( name, length );
+      if ( m_buckets )
+      {
+        for ( uint32_t bucket = hash & m_bucketMask; m_buckets[bucket]; bucket = ( bucket + 1 ) & m_bucketMask )
+        {
+          Descriptor &descriptor = m_descriptors[m_buckets[bucket] - 1];
+          if ( descriptor.hash == hash && strcmp( descriptor.name, name ) == 0 )
+            return descriptor.size || descriptor.generation != RTGeneration() ?
+              TypeID( m_buckets[bucket] - 1 ) : InvalidTypeID;
+        }
+      }
+
+      m_descriptors = (Descriptor *)realloc( m_descriptors, ( m_count + 1 ) * sizeof(Descriptor) );
+      if ( ( m_count + 1 ) * 2 > m_bucketMask + 1 )
+        rehash();
+      TypeID id = m_count++;
+      Descriptor &descriptor = m_descriptors[id];
+      memset( &descriptor, 0, sizeof(Descriptor) );
+      descriptor.name = m_names.intern( name, length );
+      descriptor.hash = hash;
+      uint32_t bucket = hash & m_bucketMask;
+      while ( m_buckets[bucket] )
+        bucket = ( bucket + 1 ) & m_bucketMask;
+      m_buckets[bucket] = id + 1;
+
+      try
+      {
+        refresh( id );
+      }
+      catch ( Exception const & )
+      {
+        m_descriptors[id].size = 0;
+      }
+      return m_descriptors[id].size ? id : InvalidTypeID;
     }
-    
-    void setOperator( DGOperator const &dgOperator );
-    DGOperator getOperator();
-    
-    void setParameterLayout(
-      uint32_t parameterCount,
-      char const **parameters
-      )
+
+    char const *getName( TypeID id )
     {
-      FEC_DGBindingSetParameterLayout(
-        getCRef(),
-        parameterCount,
-        parameters
-        );
-      Exception::MaybeThrow();
+      return get( id ).name;
     }
 
-    Variant getParameterLayout_Variant()
+    uint32_t getSize( TypeID id )
     {
-      FEC_Variant result = FEC_DGBindingGetParameterLayout_Variant(
-        getCRef()
-        );
-      Exception::MaybeThrow();
-      return Variant( &result );
+      return get( id ).size;
     }
-  };
 
-  class DGBindingList : public DGCompiledObject
-  {
-    friend class DGNode;
-    friend class DGEventHandler;
+    uint32_t getAlignment( TypeID id )
+    {
+      return getLayout( id ).alignment;
+    }
 
-  protected:
-    
-    DGBindingList( FEC_DGBindingListRef dgBindingListRef )
-      : DGCompiledObject( dgBindingListRef )
+    bool isShallow( TypeID id )
     {
+      return get( id ).shallow;
     }
-    
-  public:
-    
-    DGBindingList()
+
+    /// returns true if the member offsets of the type are known
+    bool hasMemberLayout( TypeID id )
     {
+      return getLayout( id ).layout;
     }
-    
-    DGBindingList( DGBindingList const &that )
-      : DGCompiledObject( that )
+
+    uint32_t getMemberCount( TypeID id )
     {
+      return getLayout( id ).memberCount;
     }
-    
-    DGBindingList &operator =( DGBindingList const &that )
+
+    char const *getMemberName( TypeID id, uint32_t index )
     {
-      set( that );
-      return *this;
+      return getLayout( id ).members[index].name;
     }
-    
-    void append( DGBinding const &dgBinding )
+
+    TypeID getMemberType( TypeID id, uint32_t index )
     {
-      FEC_DGBindingListAppend(
-        getCRef(),
-        dgBinding.getCRef()
-        );
-      Exception::MaybeThrow();
+      return getLayout( id ).members[index].type;
     }
 
-    void insert( DGBinding const &dgBinding, uint32_t index )
+    /// returns the byte offset of a member, valid if hasMemberLayout()
+    uint32_t getMemberOffset( TypeID id, uint32_t index )
     {
-      FEC_DGBindingListInsert(
-        getCRef(),
-        dgBinding.getCRef(),
-        index
-        );
-      Exception::MaybeThrow();
+      return getLayout( id ).members[index].offset;
     }
 
-    void remove( uint32_t index )
+    uint32_t getTypeCount() const
     {
-      FEC_DGBindingListRemove(
-        getCRef(),
-        index
-        );
-      Exception::MaybeThrow();
+      return m_count;
     }
+  };
 
-    DGBinding getBinding( uint32_t index )
+  /*
+   * C++ - Threading
+   *
+   * Minimal primitives for the schedulers below.  Without pthreads
+   * (FEC_HAS_THREADS undefined) the mutexes are no-ops and task pools
+   * run every task on the thread calling TaskPool::wait().
+   */
+
+  inline double GetSeconds()
+  {
+#if defined(FEC_HAS_THREADS)
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return double( ts.tv_sec ) + double( ts.tv_nsec ) * 1.0e-9;
+#else
+    return 0.0;
+#endif
+  }
+
+  inline uint32_t GetHardwareThreadCount()
+  {
+#if defined(FEC_HAS_THREADS) && defined(_SC_NPROCESSORS_ONLN)
+    long count = sysconf( _SC_NPROCESSORS_ONLN );
+    return count > 0 ? uint32_t( count ) : 1;
+#else
+    return 1;
+#endif
+  }
+
+  class Mutex
+  {
+    friend class Condition;
+
+  private:
+
+#if defined(FEC_HAS_THREADS)
+    pthread_mutex_t m_mutex;
+#endif
+
+    Mutex( Mutex const & );
+    Mutex &operator =( Mutex const & );
+
+  public:
+
+    Mutex()
     {
-      FEC_DGBindingRef result = FEC_DGBindingListGetBinding(
-        getCRef(),
-        index
-        );
-      Exception::MaybeThrow();
-      return DGBinding( result );
+#if defined(FEC_HAS_THREADS)
+      pthread_mutex_init( &m_mutex, 0 );
+#endif
     }
 
-    uint32_t getCount()
+    ~Mutex()
     {
-      return FEC_DGBindingListGetLength(
-        getCRef()
-        );
+#if defined(FEC_HAS_THREADS)
+      pthread_mutex_destroy( &m_mutex );
+#endif
+    }
+
+    void lock()
+    {
+#if defined(FEC_HAS_THREADS)
+      pthread_mutex_lock( &m_mutex );
+#endif
+    }
+
+    void unlock()
+    {
+#if defined(FEC_HAS_THREADS)
+      pthread_mutex_unlock( &m_mutex );
+#endif
     }
   };
-   
-  class DGNamedObject : public DGCompiledObject
+
+  class MutexLock
   {
-  protected:
-    
-    DGNamedObject( FEC_DGNamedObjectRef that )
-      : DGCompiledObject( that )
+  private:
+
+    Mutex &m_mutex;
+
+    MutexLock( MutexLock const & );
+    MutexLock &operator =( MutexLock const & );
+
+  public:
+
+    MutexLock( Mutex &mutex )
+      : m_mutex( mutex )
     {
+      m_mutex.lock();
     }
 
-    void ensureIsValid() const
+    ~MutexLock()
     {
-      if ( !isValid() )
-      {
-        FEC_Variant variant;
-        FEC_VariantInitStringCopy( &variant, FEC_STRING_CONST_DATA_LENGTH( "object has been destroyed" ) );
-        throw Exception( &variant );
-      }
+      m_mutex.unlock();
     }
-    
+  };
+
+  class Condition
+  {
+  private:
+
+#if defined(FEC_HAS_THREADS)
+    pthread_cond_t m_cond;
+#endif
+
+    Condition( Condition const & );
+    Condition &operator =( Condition const & );
+
   public:
-    
-    DGNamedObject()
+
+    Condition()
     {
+#if defined(FEC_HAS_THREADS)
+      pthread_cond_init( &m_cond, 0 );
+#endif
     }
-    
-    DGNamedObject( DGNamedObject const &that )
-      : DGCompiledObject( that )
+
+    ~Condition()
     {
+#if defined(FEC_HAS_THREADS)
+      pthread_cond_destroy( &m_cond );
+#endif
     }
-    
-    void destroy()
+
+    // the mutex has to be locked by the caller
+    void wait( Mutex &mutex )
     {
-      ensureIsValid();
-      FEC_DGNamedObjectDestroy( getCRef() );
-      invalidate();
+#if defined(FEC_HAS_THREADS)
+      pthread_cond_wait( &m_cond, &mutex.m_mutex );
+#else
+      (void)mutex;
+#endif
     }
 
-    DGNamedObject &operator =( DGNamedObject const &that )
+    void signal()
     {
-      set( that );
-      return *this;
+#if defined(FEC_HAS_THREADS)
+      pthread_cond_signal( &m_cond );
+#endif
     }
-    
-    char const *getName() const
+
+    void broadcast()
     {
-      ensureIsValid();
-      char const *result = FEC_DGNamedObjectGetName( m_ref );
-      Exception::MaybeThrow();
-      return result;
+#if defined(FEC_HAS_THREADS)
+      pthread_cond_broadcast( &m_cond );
+#endif
     }
-    
-# if defined(FEC_PROVIDE_STL_BINDINGS)
-    std::string getName_stl() const
-    {
-      ensureIsValid();
-      return std::string( getName() );
-    }
-# endif
   };
-  
-  class DGContainer : public DGNamedObject
+
+  /*!
+   * Orders every memory access before the call against every access
+   * after it, for data published to lock-free readers.
+   */
+  inline void MemoryFence()
   {
-  protected:
-    
-    DGContainer( FEC_DGContainerRef that )
-      : DGNamedObject( that )
-    {
-    }
-    
+#if defined(FEC_HAS_THREADS)
+    __sync_synchronize();
+#endif
+  }
+
+  /*!
+   * A 64-bit counter that is incremented and read without a lock.
+   */
+  class AtomicCounter
+  {
+  private:
+
+    volatile uint64_t m_value;
+
+    AtomicCounter( AtomicCounter const & );
+    AtomicCounter &operator =( AtomicCounter const & );
+
   public:
-    
-    DGContainer()
+
+    AtomicCounter()
+      : m_value( 0 )
     {
     }
-    
-    DGContainer( DGContainer const &that )
-      : DGNamedObject( that )
+
+    // returns the incremented value
+    uint64_t increment()
     {
+#if defined(FEC_HAS_THREADS)
+      return __sync_add_and_fetch( &m_value, 1 );
+#else
+      return ++m_value;
+#endif
     }
-    
-    DGContainer &operator =( DGContainer const &that )
+
+    uint64_t get() const
     {
-      set( that );
-      return *this;
+#if defined(FEC_HAS_THREADS)
+      return __sync_fetch_and_add( const_cast<volatile uint64_t *>( &m_value ), 0 );
+#else
+      return m_value;
+#endif
     }
-    
-    void addMember(
-      char const *nameCString,
-      char const *typeCString
-      )
+  };
+
+  inline AtomicCounter &RTGenerationCounter()
+  {
+    static AtomicCounter counter;
+    return counter;
+  }
+
+  /*!
+   * Counts RT registrations, extension loads and compiled KL sources, so
+   * that caches of type layouts can tell when they are stale.
+   */
+  inline void BumpRTGeneration()
+  {
+    RTGenerationCounter().increment();
+  }
+
+  // never 0, which caches use for "not computed yet"
+  inline uint64_t RTGeneration()
+  {
+    return RTGenerationCounter().get() + 1;
+  }
+
+  typedef void (*TaskFunc)( void *userdata );
+
+  /*!
+   * A work-stealing task pool.
+   *
+   * Every worker owns a deque: tasks submitted from a worker go onto
+   * its own deque and are popped LIFO, while idle workers steal FIFO
+   * from the other deques.  The thread calling wait() takes part in
+   * the work as worker 0 until every submitted task has finished.
+   */
+  class TaskPool
+  {
+  private:
+
+    struct Task
     {
-      ensureIsValid();
-      FEC_DGContainerAddMember_Variant(
-        getCRef(),
-        nameCString,
-        typeCString,
-        0
-        );
-      Exception::MaybeThrow();
+      TaskFunc func;
+      void *userdata;
+    };
+
+    struct Worker
+    {
+      TaskPool *pool;
+      uint32_t index;
+      Mutex mutex;
+      Task *tasks;
+      uint32_t head;
+      uint32_t tail;
+      uint32_t capacity;
+#if defined(FEC_HAS_THREADS)
+      pthread_t thread;
+#endif
+    };
+
+    Worker *m_workers;
+    uint32_t m_workerCount;
+    Worker m_mainWorker;
+    Mutex m_stateMutex;
+    Condition m_stateCondition;
+    int32_t m_queued;
+    int32_t m_mainQueued;
+    uint32_t m_pending;
+    uint64_t m_executedCount;
+    uint64_t m_stealCount;
+    bool m_shutdown;
+#if defined(FEC_HAS_THREADS)
+    pthread_key_t m_workerKey;
+#endif
+
+    TaskPool( TaskPool const & );
+    TaskPool &operator =( TaskPool const & );
+
+    uint32_t currentWorker() const
+    {
+#if defined(FEC_HAS_THREADS)
+      void *value = pthread_getspecific( m_workerKey );
+      return value ? uint32_t( uintptr_t( value ) - 1 ) : 0;
+#else
+      return 0;
+#endif
     }
 
-    void addMember_Variant(
-      char const *nameCString,
-      char const *typeCString,
-      Variant &defaultValue
-      )
+    static void push( Worker &worker, Task const &task )
     {
-      ensureIsValid();
-      FEC_DGContainerAddMember_Variant(
-        getCRef(),
-        nameCString,
-        typeCString,
-        defaultValue.getData()
-        );
-      Exception::MaybeThrow();
+      MutexLock lock( worker.mutex );
+      if ( worker.tail - worker.head == worker.capacity )
+      {
+        uint32_t capacity = worker.capacity ? worker.capacity * 2 : 64;
+        Task *tasks = (Task *)malloc( capacity * sizeof(Task) );
+        if ( !tasks )
+          Exception::Throw( "TaskPool: out of memory" );
+        for ( uint32_t i=worker.head; i!=worker.tail; ++i )
+          tasks[i - worker.head] = worker.tasks[i % worker.capacity];
+        free( worker.tasks );
+        worker.tasks = tasks;
+        worker.tail -= worker.head;
+        worker.head = 0;
+        worker.capacity = capacity;
+      }
+      worker.tasks[worker.tail++ % worker.capacity] = task;
     }
 
-    void removeMember(
-      char const *nameCString
-      )
+    static bool popBack( Worker &worker, Task &task )
     {
-      ensureIsValid();
-      FEC_DGContainerRemoveMember(
-        getCRef(),
-        nameCString
-        );
-      Exception::MaybeThrow();
+      MutexLock lock( worker.mutex );
+      if ( worker.head == worker.tail )
+        return false;
+      task = worker.tasks[--worker.tail % worker.capacity];
+      return true;
     }
 
-    Variant getMembers_Variant() const
+    static bool popFront( Worker &worker, Task &task )
     {
-      ensureIsValid();
-      FEC_Variant result;
-      FEC_VariantInitWithDGContainerGetMembers(
-        &result,
-        getCRef()
-        );
-      Exception::MaybeThrow();
-      return Variant( &result );
+      MutexLock lock( worker.mutex );
+      if ( worker.head == worker.tail )
+        return false;
+      task = worker.tasks[worker.head++ % worker.capacity];
+      return true;
     }
 
-    char const *getMemberType( char const *nameCString )
+    bool take( uint32_t index, Task &task )
     {
-      ensureIsValid();
-      char const *str = FEC_DGContainerGetMemberType_cstr(
-        getCRef(),
-        nameCString
-        );
-      Exception::MaybeThrow();
-      return str;
+      bool stolen = false;
+      bool found = popBack( m_workers[index], task );
+      for ( uint32_t i=1; !found && i<m_workerCount; ++i )
+      {
+        found = popFront( m_workers[( index + i ) % m_workerCount], task );
+        stolen = found;
+      }
+      if ( found )
+      {
+        MutexLock lock( m_stateMutex );
+        --m_queued;
+        if ( stolen )
+          ++m_stealCount;
+      }
+      return found;
     }
 
-    uint32_t getMemberSize( char const *nameCString )
+    bool takeMain( Task &task )
     {
-      ensureIsValid();
-      uint32_t result = FEC_DGContainerGetMemberSize(
-        getCRef(),
-        nameCString
-        );
-      Exception::MaybeThrow();
-      return result;
+      if ( !popFront( m_mainWorker, task ) )
+        return false;
+      MutexLock lock( m_stateMutex );
+      --m_mainQueued;
+      return true;
     }
 
-    bool getMemberIsShallow( char const *nameCString )
+    void run( Task const &task )
     {
-      ensureIsValid();
-      int result = FEC_DGContainerGetMemberIsShallow(
-        getCRef(),
-        nameCString
-        );
-      Exception::MaybeThrow();
-      return result;
+      task.func( task.userdata );
+      MutexLock lock( m_stateMutex );
+      ++m_executedCount;
+      if ( --m_pending == 0 )
+        m_stateCondition.broadcast();
     }
 
-    Variant getMemberDefaultData_Variant( char const *nameCString )
+#if defined(FEC_HAS_THREADS)
+    static void *WorkerMain( void *userdata )
     {
-      ensureIsValid();
-      FEC_Variant result;
-      FEC_VariantInitWithDGContainerGetMemberDefaultData(
-        &result,
-        getCRef(),
-        nameCString
-        );
-      Exception::MaybeThrow();
-      return Variant( &result );
+      Worker *worker = static_cast<Worker *>( userdata );
+      TaskPool *pool = worker->pool;
+      pthread_setspecific( pool->m_workerKey, (void *)uintptr_t( worker->index + 1 ) );
+      for ( ;; )
+      {
+        Task task;
+        if ( pool->take( worker->index, task ) )
+        {
+          pool->run( task );
+          continue;
+        }
+        MutexLock lock( pool->m_stateMutex );
+        while ( !pool->m_shutdown && pool->m_queued <= 0 )
+          pool->m_stateCondition.wait( pool->m_stateMutex );
+        if ( pool->m_shutdown )
+          break;
+      }
+      return 0;
     }
+#endif
 
-    uint32_t getSize()
+  public:
+
+    /*!
+     * Creates a pool with the given number of background threads, in
+     * addition to the thread calling wait().  A count of UINT32_MAX
+     * uses one thread per core.
+     */
+    TaskPool( uint32_t threadCount = 0xffffffffu )
+      : m_queued( 0 )
+      , m_mainQueued( 0 )
+      , m_pending( 0 )
+      , m_executedCount( 0 )
+      , m_stealCount( 0 )
+      , m_shutdown( false )
+    {
+#if defined(FEC_HAS_THREADS)
+      if ( threadCount == 0xffffffffu )
+        threadCount = GetHardwareThreadCount() - 1;
+      pthread_key_create( &m_workerKey, 0 );
+#else
+      threadCount = 0;
+#endif
+      m_workerCount = threadCount + 1;
+      m_workers = new Worker[m_workerCount];
+      for ( uint32_t i=0; i<m_workerCount; ++i )
+      {
+        m_workers[i].pool = this;
+        m_workers[i].index = i;
+        m_workers[i].tasks = 0;
+        m_workers[i].head = 0;
+        m_workers[i].tail = 0;
+        m_workers[i].capacity = 0;
+      }
+      m_mainWorker.pool = this;
+      m_mainWorker.index = 0;
+      m_mainWorker.tasks = 0;
+      m_mainWorker.head = 0;
+      m_mainWorker.tail = 0;
+      m_mainWorker.capacity = 0;
+#if defined(FEC_HAS_THREADS)
+      for ( uint32_t i=1; i<m_workerCount; ++i )
+      {
+        if ( pthread_create( &m_workers[i].thread, 0, &WorkerMain, &m_workers[i] ) != 0 )
+        {
+          m_workerCount = i;
+          break;
+        }
+      }
+#endif
+    }
+
+    ~TaskPool()
     {
-      ensureIsValid();
-      uint32_t result = FEC_DGContainerGetSize( getCRef() );
-      Exception::MaybeThrow();
-      return result;
+      {
+        MutexLock lock( m_stateMutex );
+        m_shutdown = true;
+        m_stateCondition.broadcast();
+      }
+#if defined(FEC_HAS_THREADS)
+      for ( uint32_t i=1; i<m_workerCount; ++i )
+        pthread_join( m_workers[i].thread, 0 );
+      pthread_key_delete( m_workerKey );
+#endif
+      for ( uint32_t i=0; i<m_workerCount; ++i )
+        free( m_workers[i].tasks );
+      free( m_mainWorker.tasks );
+      delete [] m_workers;
     }
-    
-    void setSize( uint32_t size )
+
+    // queues a task on the deque of the calling worker
+    void submit( TaskFunc func, void *userdata )
     {
-      ensureIsValid();
-      FEC_DGContainerSetSize(
-        getCRef(),
-        size
-        );
-      Exception::MaybeThrow();
+      Task task;
+      task.func = func;
+      task.userdata = userdata;
+      push( m_workers[currentWorker()], task );
+      MutexLock lock( m_stateMutex );
+      ++m_queued;
+      ++m_pending;
+      m_stateCondition.broadcast();
     }
-    
-    void getMemberSliceData(
-      char const *memberCString,
-      uint32_t index,
-      uint32_t bufferSize,
-      void *buffer
-      )
+
+    // queues a task that may only run on the thread calling wait(); such
+    // tasks run in submission order, ahead of any other work of that thread
+    void submitMain( TaskFunc func, void *userdata )
     {
-      ensureIsValid();
-      FEC_DGContainerGetMemberSliceData(
-        getCRef(),
-        memberCString,
-        index,
-        bufferSize,
-        buffer
-        );
-      Exception::MaybeThrow();
+      Task task;
+      task.func = func;
+      task.userdata = userdata;
+      push( m_mainWorker, task );
+      MutexLock lock( m_stateMutex );
+      ++m_mainQueued;
+      ++m_pending;
+      m_stateCondition.broadcast();
     }
-    
-    uint32_t getMemberSliceArraySize(
-      char const *memberCString,
-      uint32_t index
-      )
+
+    // runs tasks on the calling thread until all submitted tasks are done
+    void wait()
     {
-      ensureIsValid();
-      uint32_t result = FEC_DGContainerGetMemberSliceArraySize(
-        getCRef(),
-        memberCString,
-        index
-        );
-      Exception::MaybeThrow();
-      return result;
+      for ( ;; )
+      {
+        Task task;
+        if ( takeMain( task ) || take( 0, task ) )
+        {
+          run( task );
+          continue;
+        }
+        MutexLock lock( m_stateMutex );
+        if ( m_pending == 0 )
+          break;
+        if ( m_queued <= 0 && m_mainQueued <= 0 )
+          m_stateCondition.wait( m_stateMutex );
+      }
     }
-    
-    void getMemberSliceArrayData(
-      char const *memberCString,
-      uint32_t index,
-      uint32_t bufferSize,
-      void *buffer
-      )
+
+    uint32_t getThreadCount() const
     {
-      ensureIsValid();
-      FEC_DGContainerGetMemberSliceArrayData(
-        getCRef(),
-        memberCString,
-        index,
-        bufferSize,
-        buffer
-        );
-      Exception::MaybeThrow();
+      return m_workerCount;
     }
-    
-    void setMemberSliceData(
-      char const *memberCString,
-      uint32_t index,
-      uint32_t bufferSize,
-      void const *buffer
-      )
+
+    uint64_t getExecutedCount() const
     {
-      ensureIsValid();
-      FEC_DGContainerSetMemberSliceData(
-        getCRef(),
-        memberCString,
-        index,
-        bufferSize,
-        buffer
-        );
-      Exception::MaybeThrow();
+      return m_executedCount;
     }
+
+    uint64_t getStealCount() const
+    {
+      return m_stealCount;
+    }
+  };
+
+  /*
+   * C++ - Buffer Allocation
+   */
+
+  enum BufferPolicy
+  {
+    BufferPolicy_Default = 0,
+    // ask the kernel to back large buffers with transparent huge pages
+    BufferPolicy_HugePages = 1,
+    // fault the pages of large buffers in on the allocating thread, so that
+    // first-touch placement puts them on that thread's NUMA node.  Such
+    // buffers bypass the pool, which would hand them to other threads
+    BufferPolicy_FirstTouch = 2
+  };
+
+  /*!
+   * Allocates the host-side buffers used to move slice data in and out of
+   * the runtime.  Buffers of at least getLargeThreshold() bytes are mapped
+   * directly so that the huge page and first-touch policies apply to them;
+   * smaller ones go through malloc.
+   *
+   * Sizes are rounded up to size classes (four per power of two), and
+   * freed buffers are kept on a per-class free list, up to getPoolLimit()
+   * bytes, for the next allocation of the same class.  Nodes whose sizes
+   * are stable from one cook to the next then stop hitting the system
+   * allocator altogether.
+   *
+   * The pool limit defaults to 32MB, which suits a plugin sharing its host
+   * process; hosts with more headroom can raise it with setPoolLimit().
+   *
+   * The allocator is process-wide, see Default().  Its counters, and the
+   * NUMA node holding the pages of large buffers where the platform can
+   * tell, are reported by getUsage_Variant() and included in
+   * Client::getMemoryUsage_Variant().
+   */
+  class BufferAllocator
+  {
+    struct Header
+    {
+      uint64_t size;
+      uint64_t capacity;
+      Header *prev;
+      Header *next;
+      uint32_t sizeClass;
+      // 0 for malloc, 1 for mmap, 2 for mmap faulted in by first touch
+      uint32_t mapped;
+      char pad[64 - 2 * sizeof(uint64_t) - 2 * sizeof(Header *) - 2 * sizeof(uint32_t)];
+    };
+
+    enum { ClassCount = 4 * 58 + 1 };
+
+    mutable Mutex m_mutex;
+    uint32_t m_policy;
+    uint64_t m_largeThreshold;
+    uint64_t m_poolLimit;
+    Header *m_large;
+    Header *m_free[ClassCount];
+    uint64_t m_pooledBytes;
+    uint64_t m_allocationCount;
+    uint64_t m_poolHitCount;
+    uint64_t m_systemAllocationCount;
+    uint64_t m_liveCount;
+    uint64_t m_liveBytes;
+    uint64_t m_peakBytes;
+    uint64_t m_largeCount;
+    uint64_t m_hugePageBytes;
+
+    BufferAllocator( BufferAllocator const & );
+    BufferAllocator &operator =( BufferAllocator const & );
+
+    static uint64_t PageSize()
+    {
+#if defined(FEC_HAS_THREADS)
+      static uint64_t pageSize = uint64_t( sysconf( _SC_PAGESIZE ) );
+      return pageSize;
+#else
+      return 4096;
+#endif
+    }
+
+    // class 0 holds up to 64 bytes, then every power of two 2^e is split
+    // into four classes of 2^e + k * 2^(e-2)
+    static uint32_t SizeClass( uint64_t size )
+    {
+      if ( size <= 64 )
+        return 0;
+      uint32_t e = 0;
+      for ( uint64_t v = size - 1; v > 1; v >>= 1 )
+        ++e;
+      uint32_t k = uint32_t( ( ( size - 1 - ( uint64_t( 1 ) << e ) ) >> ( e - 2 ) ) + 1 );
+      return ( e - 6 ) * 4 + k;
+    }
+
+    static uint64_t ClassSize( uint32_t sizeClass )
+    {
+      if ( sizeClass == 0 )
+        return 64;
+      uint32_t e = ( sizeClass - 1 ) / 4 + 6;
+      uint32_t k = ( sizeClass - 1 ) % 4 + 1;
+      return ( uint64_t( 1 ) << e ) + k * ( uint64_t( 1 ) << ( e - 2 ) );
+    }
+
+    Header *allocateSystem( uint64_t capacity, uint32_t policy )
+    {
+      Header *header = 0;
+#if defined(FEC_HAS_THREADS) && defined(MAP_ANONYMOUS)
+      if ( capacity >= m_largeThreshold )
+      {
+        uint64_t mappedSize = ( sizeof(Header) + capacity + PageSize() - 1 ) & ~( PageSize() - 1 );
+        void *mapped = mmap( 0, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+        if ( mapped != MAP_FAILED )
+        {
+          header = static_cast<Header *>( mapped );
+          header->mapped = 1;
+# if defined(MADV_HUGEPAGE)
+          if ( ( policy & BufferPolicy_HugePages ) && madvise( mapped, mappedSize, MADV_HUGEPAGE ) == 0 )
+          {
+            MutexLock lock( m_mutex );
+            m_hugePageBytes += mappedSize;
+          }
+# endif
+          if ( policy & BufferPolicy_FirstTouch )
+          {
+            header->mapped = 2;
+            char *bytes = static_cast<char *>( mapped );
+            for ( uint64_t offset = PageSize(); offset < mappedSize; offset += PageSize() )
+              bytes[offset] = 0;
+          }
+        }
+      }
+#endif
+      if ( !header )
+      {
+        header = static_cast<Header *>( malloc( size_t( sizeof(Header) + capacity ) ) );
+        if ( !header )
+          return 0;
+        header->mapped = 0;
+      }
+      header->capacity = capacity;
+      return header;
+    }
+
+    static void FreeSystem( Header *header )
+    {
+#if defined(FEC_HAS_THREADS) && defined(MAP_ANONYMOUS)
+      if ( header->mapped )
+      {
+        munmap( header, size_t( ( sizeof(Header) + header->capacity + PageSize() - 1 ) & ~( PageSize() - 1 ) ) );
+        return;
+      }
+#endif
+      free( header );
+    }
+
+    void link( Header *header )
+    {
+      header->prev = 0;
+      header->next = m_large;
+      if ( m_large )
+        m_large->prev = header;
+      m_large = header;
+    }
+
+    void unlink( Header *header )
+    {
+      if ( header->prev )
+        header->prev->next = header->next;
+      else
+        m_large = header->next;
+      if ( header->next )
+        header->next->prev = header->prev;
+    }
+
+  public:
+
+    BufferAllocator()
+      : m_policy( BufferPolicy_Default )
+      , m_largeThreshold( 2 * 1024 * 1024 )
+      , m_poolLimit( uint64_t( 32 ) * 1024 * 1024 )
+      , m_large( 0 )
+      , m_pooledBytes( 0 )
+      , m_allocationCount( 0 )
+      , m_poolHitCount( 0 )
+      , m_systemAllocationCount( 0 )
+      , m_liveCount( 0 )
+      , m_liveBytes( 0 )
+      , m_peakBytes( 0 )
+      , m_largeCount( 0 )
+      , m_hugePageBytes( 0 )
+    {
+      memset( m_free, 0, sizeof(m_free) );
+    }
+
+    ~BufferAllocator()
+    {
+      trim();
+    }
+
+    /*!
+     * The process-wide allocator.  It is never destroyed, since buffers
+     * held by other static objects may still be released to it during
+     * static destruction; the pooled buffers go back to the system with
+     * the process.
+     */
+    static BufferAllocator &Default()
+    {
+      static BufferAllocator *allocator = new BufferAllocator;
+      return *allocator;
+    }
+
+    // a combination of BufferPolicy flags, applied to later allocations
+    void setPolicy( uint32_t policy )
+    {
+      MutexLock lock( m_mutex );
+      m_policy = policy;
+    }
+
+    uint32_t getPolicy() const
+    {
+      MutexLock lock( m_mutex );
+      return m_policy;
+    }
+
+    void setLargeThreshold( uint64_t bytes )
+    {
+      m_largeThreshold = bytes;
+    }
+
+    uint64_t getLargeThreshold() const
+    {
+      return m_largeThreshold;
+    }
+
+    // the most bytes kept on the free lists, 0 disables pooling
+    void setPoolLimit( uint64_t bytes )
+    {
+      m_poolLimit = bytes;
+      if ( m_pooledBytes > m_poolLimit )
+        trim();
+    }
+
+    uint64_t getPoolLimit() const
+    {
+      return m_poolLimit;
+    }
+
+    void *allocate( uint64_t size )
+    {
+      uint32_t sizeClass = SizeClass( size );
+      Header *header = 0;
+      uint32_t policy;
+      {
+        MutexLock lock( m_mutex );
+        ++m_allocationCount;
+        policy = m_policy;
+        // a pooled buffer keeps the placement of the thread that first
+        // faulted it in, so first-touch buffers are always fresh
+        bool firstTouch = ( policy & BufferPolicy_FirstTouch ) && ClassSize( sizeClass ) >= m_largeThreshold;
+        header = firstTouch ? 0 : m_free[sizeClass];
+        if ( header )
+        {
+          m_free[sizeClass] = header->next;
+          m_pooledBytes -= header->capacity;
+          ++m_poolHitCount;
+        }
+      }
+      if ( !header )
+      {
+        header = allocateSystem( ClassSize( sizeClass ), policy );
+        if ( !header )
+          return 0;
+        MutexLock lock( m_mutex );
+        ++m_systemAllocationCount;
+      }
+      header->size = size;
+      header->sizeClass = sizeClass;
+
+      MutexLock lock( m_mutex );
+      ++m_liveCount;
+      m_liveBytes += size;
+      if ( m_liveBytes > m_peakBytes )
+        m_peakBytes = m_liveBytes;
+      if ( header->mapped )
+      {
+        ++m_largeCount;
+        link( header );
+      }
+      return header + 1;
+    }
+
+    void deallocate( void *data )
+    {
+      if ( !data )
+        return;
+      Header *header = static_cast<Header *>( data ) - 1;
+      {
+        MutexLock lock( m_mutex );
+        --m_liveCount;
+        m_liveBytes -= header->size;
+        if ( header->mapped )
+        {
+          --m_largeCount;
+          unlink( header );
+        }
+        if ( header->mapped != 2 && m_pooledBytes + header->capacity <= m_poolLimit )
+        {
+          header->next = m_free[header->sizeClass];
+          m_free[header->sizeClass] = header;
+          m_pooledBytes += header->capacity;
+          return;
+        }
+      }
+      FreeSystem( header );
+    }
+
+    // like realloc, keeps the first min(old, new) bytes
+    void *reallocate( void *data, uint64_t size )
+    {
+      if ( !data )
+        return allocate( size );
+      Header *header = static_cast<Header *>( data ) - 1;
+      if ( size <= header->capacity )
+      {
+        MutexLock lock( m_mutex );
+        m_liveBytes = m_liveBytes - header->size + size;
+        if ( m_liveBytes > m_peakBytes )
+          m_peakBytes = m_liveBytes;
+        header->size = size;
+        return data;
+      }
+      void *result = allocate( size );
+      if ( !result )
+        return 0;
+      memcpy( result, data, size_t( header->size ) );
+      deallocate( data );
+      return result;
+    }
+
+    // returns every pooled buffer to the system
+    void trim()
+    {
+      Header *freed = 0;
+      {
+        MutexLock lock( m_mutex );
+        for ( uint32_t i=0; i<ClassCount; ++i )
+        {
+          while ( m_free[i] )
+          {
+            Header *header = m_free[i];
+            m_free[i] = header->next;
+            header->next = freed;
+            freed = header;
+          }
+        }
+        m_pooledBytes = 0;
+      }
+      while ( freed )
+      {
+        Header *header = freed;
+        freed = header->next;
+        FreeSystem( header );
+      }
+    }
+
+    uint64_t getAllocationCount() const
+    {
+      return m_allocationCount;
+    }
+
+    uint64_t getPoolHitCount() const
+    {
+      return m_poolHitCount;
+    }
+
+    double getPoolHitRate() const
+    {
+      return m_allocationCount > 0
+        ? double( m_poolHitCount ) / double( m_allocationCount ) : 0.0;
+    }
+
+    Variant getUsage_Variant()
+    {
+      MutexLock lock( m_mutex );
+      Variant result = Variant::CreateDict();
+      result.setDictValue( "policy", Variant::CreateUInt32( m_policy ) );
+      result.setDictValue( "largeThreshold", Variant::CreateUInt64( m_largeThreshold ) );
+      result.setDictValue( "allocationCount", Variant::CreateUInt64( m_allocationCount ) );
+      result.setDictValue( "systemAllocationCount", Variant::CreateUInt64( m_systemAllocationCount ) );
+      result.setDictValue( "poolHitCount", Variant::CreateUInt64( m_poolHitCount ) );
+      result.setDictValue( "poolHitRate", Variant::CreateFloat64( getPoolHitRate() ) );
+      result.setDictValue( "pooledBytes", Variant::CreateUInt64( m_pooledBytes ) );
+      result.setDictValue( "poolLimit", Variant::CreateUInt64( m_poolLimit ) );
+      result.setDictValue( "liveCount", Variant::CreateUInt64( m_liveCount ) );
+      result.setDictValue( "liveBytes", Variant::CreateUInt64( m_liveBytes ) );
+      result.setDictValue( "peakBytes", Variant::CreateUInt64( m_peakBytes ) );
+      result.setDictValue( "largeAllocationCount", Variant::CreateUInt64( m_largeCount ) );
+      result.setDictValue( "hugePageBytes", Variant::CreateUInt64( m_hugePageBytes ) );
+
+#if defined(__linux__) && defined(SYS_move_pages)
+      // samples up to 64 pages of every live large buffer and asks the
+      // kernel which NUMA node holds them
+      enum { MaxNodes = 64, Samples = 64 };
+      uint64_t pagesByNode[MaxNodes];
+      uint64_t unresidentPages = 0;
+      memset( pagesByNode, 0, sizeof(pagesByNode) );
+      for ( Header *header = m_large; header; header = header->next )
+      {
+        uint64_t pageCount = ( sizeof(Header) + header->capacity + PageSize() - 1 ) / PageSize();
+        uint64_t step = pageCount > Samples ? pageCount / Samples : 1;
+        void *pages[Samples];
+        int status[Samples];
+        unsigned long count = 0;
+        for ( uint64_t page = 0; page < pageCount && count < Samples; page += step )
+          pages[count++] = reinterpret_cast<char *>( header ) + page * PageSize();
+        if ( syscall( SYS_move_pages, 0, count, pages, 0, status, 0 ) != 0 )
+          continue;
+        for ( unsigned long i=0; i<count; ++i )
+        {
+          if ( status[i] >= 0 && status[i] < MaxNodes )
+            pagesByNode[status[i]] += step;
+          else
+            unresidentPages += step;
+        }
+      }
+      Variant nodes = Variant::CreateDict();
+      for ( uint32_t i=0; i<MaxNodes; ++i )
+      {
+        if ( pagesByNode[i] == 0 )
+          continue;
+        char key[16];
+        sprintf( key, "%u", unsigned( i ) );
+        nodes.setDictValue( key, Variant::CreateUInt64( pagesByNode[i] ) );
+      }
+      result.setDictValue( "sampledPagesByNode", nodes );
+      result.setDictValue( "sampledUnresidentPages", Variant::CreateUInt64( unresidentPages ) );
+#endif
+      return result;
+    }
+  };
+
+  /*
+   * C++ - DG Write Tracking
+   */
+
+  /*!
+   * Versions of the data written to DG containers while a DGSelectCache
+   * exists.
+   *
+   * Containers are keyed by name, which stays the same for every handle
+   * to a container, unlike its C reference.  DGContainer setters bump the
+   * container written, and evaluations and fires made through a
+   * DGSelectCache bump the containers they may write.  Versions are drawn
+   * from one clock, so a container that is destroyed and created again
+   * under the same name never repeats a version.  BumpAll() invalidates
+   * every version at once, for writes whose containers can't be told.
+   *
+   * Nothing is recorded while no cache exists: Bump() then only reads a
+   * counter, and the table is emptied when the last cache goes away.
+   * Destroying a container retires its entry.
+   */
+  class DGWriteVersions
+  {
+    struct Slot
+    {
+      Slot *next;
+      uint32_t hash;
+      uint64_t version;
+      SmallString name;
+    };
+
+    struct State
+    {
+      Mutex mutex;
+      volatile uint32_t caches;
+      Slot **buckets;
+      uint32_t bucketCount;
+      uint32_t count;
+      uint64_t clock;
+      AtomicCounter generation;
+
+      State()
+        : caches( 0 )
+        , buckets( 0 )
+        , bucketCount( 0 )
+        , count( 0 )
+        , clock( 0 )
+      {
+      }
+
+      ~State()
+      {
+        clear();
+      }
+
+      void clear()
+      {
+        for ( uint32_t i=0; i<bucketCount; ++i )
+        {
+          while ( buckets[i] )
+          {
+            Slot *next = buckets[i]->next;
+            delete buckets[i];
+            buckets[i] = next;
+          }
+        }
+        free( buckets );
+        buckets = 0;
+        bucketCount = 0;
+        count = 0;
+      }
+
+      Slot **find( char const *name, uint32_t length, uint32_t hash )
+      {
+        if ( !bucketCount )
+          return 0;
+        Slot **link = &buckets[hash & ( bucketCount - 1 )];
+        while ( *link && ( (*link)->hash != hash || !(*link)->name.equals( name, length ) ) )
+          link = &(*link)->next;
+        return link;
+      }
+
+      void grow()
+      {
+        uint32_t bucketCount_ = bucketCount ? bucketCount * 2 : 64;
+        Slot **buckets_ = (Slot **)calloc( bucketCount_, sizeof(Slot *) );
+        if ( !buckets_ )
+          Exception::Throw( "DGWriteVersions: out of memory" );
+        for ( uint32_t i=0; i<bucketCount; ++i )
+        {
+          while ( buckets[i] )
+          {
+            Slot *slot = buckets[i];
+            buckets[i] = slot->next;
+            slot->next = buckets_[slot->hash & ( bucketCount_ - 1 )];
+            buckets_[slot->hash & ( bucketCount_ - 1 )] = slot;
+          }
+        }
+        free( buckets );
+        buckets = buckets_;
+        bucketCount = bucketCount_;
+      }
+    };
+
+    static State &GetState()
+    {
+      static State state;
+      return state;
+    }
+
+    friend class DGSelectCache;
+
+    static void AttachCache()
+    {
+      State &state = GetState();
+      MutexLock lock( state.mutex );
+      ++state.caches;
+    }
+
+    static void DetachCache()
+    {
+      State &state = GetState();
+      MutexLock lock( state.mutex );
+      if ( --state.caches == 0 )
+        state.clear();
+    }
+
+  public:
+
+    // whether any cache is recording versions
+    static bool IsActive()
+    {
+      return GetState().caches != 0;
+    }
+
+    // records a write to the named container
+    static void Bump( char const *name )
+    {
+      State &state = GetState();
+      if ( !state.caches || !name )
+        return;
+      uint32_t length = uint32_t( strlen( name ) );
+      uint32_t hash = HashString( name, length );
+      MutexLock lock( state.mutex );
+      if ( !state.caches )
+        return;
+      Slot **link = state.find( name, length, hash );
+      if ( !link || !*link )
+      {
+        if ( ( state.count + 1 ) * 2 > state.bucketCount )
+          state.grow();
+        link = state.find( name, length, hash );
+        Slot *slot = new Slot;
+        slot->next = 0;
+        slot->hash = hash;
+        slot->name.assign( name, length );
+        *link = slot;
+        ++state.count;
+      }
+      (*link)->version = ++state.clock;
+    }
+
+    // the version of the named container, 0 if it hasn't been written
+    static uint64_t Get( char const *name )
+    {
+      State &state = GetState();
+      if ( !name )
+        return 0;
+      uint32_t length = uint32_t( strlen( name ) );
+      uint32_t hash = HashString( name, length );
+      MutexLock lock( state.mutex );
+      Slot **link = state.find( name, length, hash );
+      return link && *link ? (*link)->version : 0;
+    }
+
+    // forgets the named container once it has been destroyed
+    static void Retire( char const *name )
+    {
+      State &state = GetState();
+      if ( !state.caches || !name )
+        return;
+      uint32_t length = uint32_t( strlen( name ) );
+      uint32_t hash = HashString( name, length );
+      MutexLock lock( state.mutex );
+      Slot **link = state.find( name, length, hash );
+      if ( !link || !*link )
+        return;
+      Slot *slot = *link;
+      *link = slot->next;
+      delete slot;
+      --state.count;
+      // a cache may have seen the container before its first write
+      state.generation.increment();
+    }
+
+    // invalidates the versions of every container
+    static void BumpAll()
+    {
+      GetState().generation.increment();
+    }
+
+    // changes whenever BumpAll() is called
+    static uint64_t GetGeneration()
+    {
+      return GetState().generation.get();
+    }
+  };
+
+  /*
+   * C++ - DG
+   */
+  
+  inline Variant Client::getMemoryUsage_Variant()
+  {
+    FEC_Variant result = FEC_ClientGetMemoryUsage_Variant(
+      getCRef()
+      );
+    Exception::MaybeThrow();
+    Variant usage( &result );
+    if ( usage.isDict() )
+      usage.setDictValue( "hostBuffers", BufferAllocator::Default().getUsage_Variant() );
+    return usage;
+  }
+
+  class DGCompiledObject : public Ref
+  {
+  protected:
+    
+    DGCompiledObject( FEC_DGCompiledObjectRef that )
+      : Ref( that )
+    {
+    }
+    
+  public:
+    
+    DGCompiledObject()
+    {
+    }
+    
+    DGCompiledObject( DGCompiledObject const &that )
+      : Ref( that )
+    {
+    }
+    
+    DGCompiledObject &operator =( DGCompiledObject const &that )
+    {
+      set( that );
+      return *this;
+    }
+    
+    Variant getErrors()
+    {
+      FEC_DGCompiledObjectPrepareForExecution( getCRef() );
+      Exception::MaybeThrow();
+
+      FEC_Variant result = FEC_DGCompiledObjectGetErrors_Variant( getCRef() );
+      Exception::MaybeThrow();
+      return Variant( &result );
+    }
+  };
+  
+  class DGOperator;
+  
+  class DGBinding : public DGCompiledObject
+  {
+    friend class DGBindingList;
+
+  protected:
+    
+    DGBinding( FEC_DGBindingRef dgBindingRef )
+      : DGCompiledObject( dgBindingRef )
+    {
+    }
+    
+  public:
+    
+    DGBinding()
+    {
+    }
+    
+    DGBinding( Client const &client )
+      : DGCompiledObject( FEC_DGBindingCreateEmpty( client.getCRef() ) )
+    {
+    }
+    
+    DGBinding(
+      DGOperator const &dgOperator,
+      uint32_t parameterCount,
+      char const **parameters
+      );
+    
+    DGBinding( DGBinding const &that )
+      : DGCompiledObject( that )
+    {
+    }
+    
+    DGBinding &operator =( DGBinding const &that )
+    {
+      set( that );
+      return *this;
+    }
+    
+    void setOperator( DGOperator const &dgOperator );
+    DGOperator getOperator();
+    
+    void setParameterLayout(
+      uint32_t parameterCount,
+      char const **parameters
+      )
+    {
+      FEC_DGBindingSetParameterLayout(
+        getCRef(),
+        parameterCount,
+        parameters
+        );
+      Exception::MaybeThrow();
+    }
+
+    Variant getParameterLayout_Variant()
+    {
+      FEC_Variant result = FEC_DGBindingGetParameterLayout_Variant(
+        getCRef()
+        );
+      Exception::MaybeThrow();
+      return Variant( &result );
+    }
+  };
+
+  class DGBindingList : public DGCompiledObject
+  {
+    friend class DGNode;
+    friend class DGEventHandler;
+
+  protected:
+    
+    DGBindingList( FEC_DGBindingListRef dgBindingListRef )
+      : DGCompiledObject( dgBindingListRef )
+    {
+    }
+    
+  public:
+    
+    DGBindingList()
+    {
+    }
+    
+    DGBindingList( DGBindingList const &that )
+      : DGCompiledObject( that )
+    {
+    }
+    
+    DGBindingList &operator =( DGBindingList const &that )
+    {
+      set( that );
+      return *this;
+    }
+    
+    void append( DGBinding const &dgBinding )
+    {
+      FEC_DGBindingListAppend(
+        getCRef(),
+        dgBinding.getCRef()
+        );
+      Exception::MaybeThrow();
+    }
+
+    void insert( DGBinding const &dgBinding, uint32_t index )
+    {
+      FEC_DGBindingListInsert(
+        getCRef(),
+        dgBinding.getCRef(),
+        index
+        );
+      Exception::MaybeThrow();
+    }
+
+    void remove( uint32_t index )
+    {
+      FEC_DGBindingListRemove(
+        getCRef(),
+        index
+        );
+      Exception::MaybeThrow();
+    }
+
+    DGBinding getBinding( uint32_t index )
+    {
+      FEC_DGBindingRef result = FEC_DGBindingListGetBinding(
+        getCRef(),
+        index
+        );
+      Exception::MaybeThrow();
+      return DGBinding( result );
+    }
+
+    uint32_t getCount()
+    {
+      return FEC_DGBindingListGetLength(
+        getCRef()
+        );
+    }
+  };
+   
+  class DGNamedObject : public DGCompiledObject
+  {
+  protected:
+    
+    DGNamedObject( FEC_DGNamedObjectRef that )
+      : DGCompiledObject( that )
+    {
+    }
+
+    void ensureIsValid() const
+    {
+      if ( !isValid() )
+      {
+        FEC_Variant variant;
+        FEC_VariantInitStringCopy( &variant, FEC_STRING_CONST_DATA_LENGTH( "object has been destroyed" ) );
+        throw Exception( &variant );
+      }
+    }
+    
+  public:
+    
+    DGNamedObject()
+    {
+    }
+    
+    DGNamedObject( DGNamedObject const &that )
+      : DGCompiledObject( that )
+    {
+    }
+    
+    void destroy()
+    {
+      ensureIsValid();
+      if ( DGWriteVersions::IsActive() )
+        DGWriteVersions::Retire( getName() );
+      FEC_DGNamedObjectDestroy( getCRef() );
+      invalidate();
+    }
+
+    DGNamedObject &operator =( DGNamedObject const &that )
+    {
+      set( that );
+      return *this;
+    }
+    
+    char const *getName() const
+    {
+      ensureIsValid();
+      char const *result = FEC_DGNamedObjectGetName( m_ref );
+      Exception::MaybeThrow();
+      return result;
+    }
+    
+# if defined(FEC_PROVIDE_STL_BINDINGS)
+    std::string getName_stl() const
+    {
+      ensureIsValid();
+      return std::string( getName() );
+    }
+# endif
+  };
+  
+  class DGContainer : public DGNamedObject
+  {
+  protected:
+    
+    DGContainer( FEC_DGContainerRef that )
+      : DGNamedObject( that )
+    {
+    }
+
+    // tells DGSelectCache instances that the container was written
+    void bumpWriteVersion() const
+    {
+      if ( DGWriteVersions::IsActive() )
+        DGWriteVersions::Bump( getName() );
+    }
+    
+  public:
+    
+    DGContainer()
+    {
+    }
+    
+    DGContainer( DGContainer const &that )
+      : DGNamedObject( that )
+    {
+    }
+    
+    DGContainer &operator =( DGContainer const &that )
+    {
+      set( that );
+      return *this;
+    }
+    
+    void addMember(
+      char const *nameCString,
+      char const *typeCString
+      )
+    {
+      ensureIsValid();
+      FEC_DGContainerAddMember_Variant(
+        getCRef(),
+        nameCString,
+        typeCString,
+        0
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+
+    void addMember_Variant(
+      char const *nameCString,
+      char const *typeCString,
+      Variant &defaultValue
+      )
+    {
+      ensureIsValid();
+      FEC_DGContainerAddMember_Variant(
+        getCRef(),
+        nameCString,
+        typeCString,
+        defaultValue.getData()
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+
+    void removeMember(
+      char const *nameCString
+      )
+    {
+      ensureIsValid();
+      FEC_DGContainerRemoveMember(
+        getCRef(),
+        nameCString
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+
+    Variant getMembers_Variant() const
+    {
+      ensureIsValid();
+      FEC_Variant result;
+      FEC_VariantInitWithDGContainerGetMembers(
+        &result,
+        getCRef()
+        );
+      Exception::MaybeThrow();
+      return Variant( &result );
+    }
+
+    char const *getMemberType( char const *nameCString )
+    {
+      ensureIsValid();
+      char const *str = FEC_DGContainerGetMemberType_cstr(
+        getCRef(),
+        nameCString
+        );
+      Exception::MaybeThrow();
+      return str;
+    }
+
+    uint32_t getMemberSize( char const *nameCString )
+    {
+      ensureIsValid();
+      uint32_t result = FEC_DGContainerGetMemberSize(
+        getCRef(),
+        nameCString
+        );
+      Exception::MaybeThrow();
+      return result;
+    }
+
+    bool getMemberIsShallow( char const *nameCString )
+    {
+      ensureIsValid();
+      int result = FEC_DGContainerGetMemberIsShallow(
+        getCRef(),
+        nameCString
+        );
+      Exception::MaybeThrow();
+      return result;
+    }
+
+    Variant getMemberDefaultData_Variant( char const *nameCString )
+    {
+      ensureIsValid();
+      FEC_Variant result;
+      FEC_VariantInitWithDGContainerGetMemberDefaultData(
+        &result,
+        getCRef(),
+        nameCString
+        );
+      Exception::MaybeThrow();
+      return Variant( &result );
+    }
+
+    uint32_t getSize()
+    {
+      ensureIsValid();
+      uint32_t result = FEC_DGContainerGetSize( getCRef() );
+      Exception::MaybeThrow();
+      return result;
+    }
+    
+    void setSize( uint32_t size )
+    {
+      ensureIsValid();
+      FEC_DGContainerSetSize(
+        getCRef(),
+        size
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+    
+    void getMemberSliceData(
+      char const *memberCString,
+      uint32_t index,
+      uint32_t bufferSize,
+      void *buffer
+      )
+    {
+      ensureIsValid();
+      FEC_DGContainerGetMemberSliceData(
+        getCRef(),
+        memberCString,
+        index,
+        bufferSize,
+        buffer
+        );
+      Exception::MaybeThrow();
+    }
+    
+    uint32_t getMemberSliceArraySize(
+      char const *memberCString,
+      uint32_t index
+      )
+    {
+      ensureIsValid();
+      uint32_t result = FEC_DGContainerGetMemberSliceArraySize(
+        getCRef(),
+        memberCString,
+        index
+        );
+      Exception::MaybeThrow();
+      return result;
+    }
+    
+    void getMemberSliceArrayData(
+      char const *memberCString,
+      uint32_t index,
+      uint32_t bufferSize,
+      void *buffer
+      )
+    {
+      ensureIsValid();
+      FEC_DGContainerGetMemberSliceArrayData(
+        getCRef(),
+        memberCString,
+        index,
+        bufferSize,
+        buffer
+        );
+      Exception::MaybeThrow();
+    }
+    
+    void setMemberSliceData(
+      char const *memberCString,
+      uint32_t index,
+      uint32_t bufferSize,
+      void const *buffer
+      )
+    {
+      ensureIsValid();
+      FEC_DGContainerSetMemberSliceData(
+        getCRef(),
+        memberCString,
+        index,
+        bufferSize,
+        buffer
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+    
+    void setMemberSliceArraySize(
+      char const *memberCString,
+      uint32_t index,
+      uint32_t size
+      )
+    {
+      ensureIsValid();
+      FEC_DGContainerSetMemberSliceArraySize(
+        getCRef(),
+        memberCString,
+        index,
+        size
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+    
+    void setMemberSliceArrayData(
+      char const *memberCString,
+      uint32_t index,
+      uint32_t bufferSize,
+      void const *buffer
+      )
+    {
+      ensureIsValid();
+      FEC_DGContainerSetMemberSliceArrayData(
+        getCRef(),
+        memberCString,
+        index,
+        bufferSize,
+        buffer
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+    
+    void getMemberAllSlicesData(
+      char const *memberCString,
+      uint32_t bufferSize,
+      void *buffer
+      )
+    {
+      ensureIsValid();
+      FEC_DGContainerGetMemberAllSlicesData(
+        getCRef(),
+        memberCString,
+        bufferSize,
+        buffer
+        );
+      Exception::MaybeThrow();
+    }
+    
+    void setMemberAllSlicesData(
+      char const *memberCString,
+      uint32_t bufferSize,
+      void const *buffer
+      )
+    {
+      ensureIsValid();
+      FEC_DGContainerSetMemberAllSlicesData(
+        getCRef(),
+        memberCString,
+        bufferSize,
+        buffer
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+    
+    /*!
+     * The ranged accessors below copy the slices [begin, end) of a member,
+     * packed back to back in the buffer, so partial updates cost time
+     * proportional to the range rather than the container.  The C API has
+     * no ranged call, so they check the range and buffer once and then
+     * make one per-slice call for each slice of the range.
+     */
+    void getMemberSlicesData(
+      char const *memberCString,
+      uint32_t begin,
+      uint32_t end,
+      uint32_t bufferSize,
+      void *buffer
+      )
+    {
+      uint32_t sliceSize = checkSliceRange( memberCString, begin, end, bufferSize );
+      char *data = static_cast<char *>( buffer );
+      for ( uint32_t i=begin; i<end; ++i, data += sliceSize )
+      {
+        FEC_DGContainerGetMemberSliceData(
+          getCRef(),
+          memberCString,
+          i,
+          sliceSize,
+          data
+          );
+        Exception::MaybeThrow();
+      }
+    }
+
+    void setMemberSlicesData(
+      char const *memberCString,
+      uint32_t begin,
+      uint32_t end,
+      uint32_t bufferSize,
+      void const *buffer
+      )
+    {
+      uint32_t sliceSize = checkSliceRange( memberCString, begin, end, bufferSize );
+      bumpWriteVersion();
+      char const *data = static_cast<char const *>( buffer );
+      for ( uint32_t i=begin; i<end; ++i, data += sliceSize )
+      {
+        FEC_DGContainerSetMemberSliceData(
+          getCRef(),
+          memberCString,
+          i,
+          sliceSize,
+          data
+          );
+        Exception::MaybeThrow();
+      }
+    }
+
+    // fills arraySizes[0 .. end-begin) and returns the total element count
+    uint32_t getMemberSlicesArraySizes(
+      char const *memberCString,
+      uint32_t begin,
+      uint32_t end,
+      uint32_t *arraySizes
+      )
+    {
+      checkSliceRange( begin, end );
+      uint32_t total = 0;
+      for ( uint32_t i=begin; i<end; ++i )
+      {
+        arraySizes[i - begin] = FEC_DGContainerGetMemberSliceArraySize(
+          getCRef(),
+          memberCString,
+          i
+          );
+        Exception::MaybeThrow();
+        total += arraySizes[i - begin];
+      }
+      return total;
+    }
+
+    // reads the arrays of [begin, end) packed back to back, arraySizes being
+    // the result of getMemberSlicesArraySizes for the same range
+    void getMemberSlicesArrayData(
+      char const *memberCString,
+      uint32_t begin,
+      uint32_t end,
+      uint32_t const *arraySizes,
+      uint32_t elementSize,
+      uint32_t bufferSize,
+      void *buffer
+      )
+    {
+      checkSliceRange( begin, end );
+      checkArrayRange( begin, end, arraySizes, elementSize, bufferSize );
+      char *data = static_cast<char *>( buffer );
+      for ( uint32_t i=begin; i<end; ++i )
+      {
+        uint32_t bytes = arraySizes[i - begin] * elementSize;
+        if ( bytes == 0 )
+          continue;
+        FEC_DGContainerGetMemberSliceArrayData(
+          getCRef(),
+          memberCString,
+          i,
+          bytes,
+          data
+          );
+        Exception::MaybeThrow();
+        data += bytes;
+      }
+    }
+
+    // resizes the arrays of [begin, end) to arraySizes and sets their data
+    // from the packed buffer
+    void setMemberSlicesArrayData(
+      char const *memberCString,
+      uint32_t begin,
+      uint32_t end,
+      uint32_t const *arraySizes,
+      uint32_t elementSize,
+      uint32_t bufferSize,
+      void const *buffer
+      )
+    {
+      checkSliceRange( begin, end );
+      checkArrayRange( begin, end, arraySizes, elementSize, bufferSize );
+      bumpWriteVersion();
+      char const *data = static_cast<char const *>( buffer );
+      for ( uint32_t i=begin; i<end; ++i )
+      {
+        uint32_t bytes = arraySizes[i - begin] * elementSize;
+        FEC_DGContainerSetMemberSliceArraySize(
+          getCRef(),
+          memberCString,
+          i,
+          arraySizes[i - begin]
+          );
+        Exception::MaybeThrow();
+        if ( bytes == 0 )
+          continue;
+        FEC_DGContainerSetMemberSliceArrayData(
+          getCRef(),
+          memberCString,
+          i,
+          bytes,
+          data
+          );
+        Exception::MaybeThrow();
+        data += bytes;
+      }
+    }
+
+    float getMemberSliceData_Float32(
+      char const *memberCString,
+      uint32_t index
+      )
+    {
+      ensureIsValid();
+      float result = FEC_DGContainerGetMemberSliceData_Float32(
+        getCRef(),
+        memberCString,
+        index
+        );
+      Exception::MaybeThrow();
+      return result;
+    }
+    
+    void setMemberSliceData_Float32(
+      char const *memberCString,
+      uint32_t index,
+      float value
+      )
+    {
+      ensureIsValid();
+      FEC_DGContainerSetMemberSliceData_Float32(
+        getCRef(),
+        memberCString,
+        index,
+        value
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+    
+    Variant getMemberSliceData_Variant(
+      char const *memberCString,
+      uint32_t index
+      )
+    {
+      ensureIsValid();
+      FEC_Variant result;
+      FEC_VariantInitWithDGContainerGetMemberSlice(
+        &result,
+        getCRef(),
+        memberCString,
+        index
+        );
+      Exception::MaybeThrow();
+      return Variant( &result );
+    }
+    
+    void setMemberSliceData_Variant(
+      char const *memberCString,
+      uint32_t index,
+      Variant &variant
+      )
+    {
+      ensureIsValid();
+      FEC_DGContainerSetMemberSlice_Variant(
+        getCRef(),
+        memberCString,
+        index,
+        variant.getData()
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+    
+    void setSliceData_Variant(
+      uint32_t index,
+      Variant &variant
+      )
+    {
+      ensureIsValid();
+      FEC_DGContainerSetSlice_Variant(
+        getCRef(),
+        index,
+        variant.getData()
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+    
+    Variant getBulkData_Variant()
+    {
+      ensureIsValid();
+      FEC_Variant result;
+      FEC_VariantInitWithDGContainerGetBulkData( &result, getCRef() );
+      Exception::MaybeThrow();
+      return Variant( &result );
+    }
+    
+    void setBulkData_Variant( Variant &variant )
+    {
+      ensureIsValid();
+      FEC_DGContainerSetBulkData_Variant( getCRef(), variant.getData() );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+
+  private:
+
+    // throws unless [begin, end) lies within the container
+    void checkSliceRange( uint32_t begin, uint32_t end )
+    {
+      ensureIsValid();
+      if ( begin > end || end > getSize() )
+        Exception::Throw( "DGContainer: slice range out of bounds" );
+    }
+
+    // checks the range and buffer of a shallow member, returns its slice size
+    uint32_t checkSliceRange(
+      char const *memberCString,
+      uint32_t begin,
+      uint32_t end,
+      uint32_t bufferSize
+      )
+    {
+      checkSliceRange( begin, end );
+      uint32_t sliceSize = getMemberSize( memberCString );
+      if ( uint64_t( sliceSize ) * ( end - begin ) > bufferSize )
+        Exception::Throw( "DGContainer: buffer too small for the slice range" );
+      return sliceSize;
+    }
+
+    static void checkArrayRange(
+      uint32_t begin,
+      uint32_t end,
+      uint32_t const *arraySizes,
+      uint32_t elementSize,
+      uint32_t bufferSize
+      )
+    {
+      uint64_t bytes = 0;
+      for ( uint32_t i=begin; i<end; ++i )
+        bytes += uint64_t( arraySizes[i - begin] ) * elementSize;
+      if ( bytes > bufferSize )
+        Exception::Throw( "DGContainer: buffer too small for the slice range" );
+    }
+  };
+  
+  class DGNode : public DGContainer
+  {
+  protected:
+    
+    DGNode( FEC_DGNodeRef that )
+      : DGContainer( that )
+    {
+    }
+    
+  public:
+    
+    DGNode()
+    {
+    }
+    
+    DGNode(
+      Client const &client,
+      char const *nameCString
+      )
+      : DGContainer( FEC_DGNodeCreate(
+        client.getCRef(),
+        nameCString
+        ) )
+    {
+    }
+    
+    DGNode( DGNode const &that )
+      : DGContainer( that )
+    {
+    }
+    
+    DGNode &operator =( DGNode const &that )
+    {
+      set( that );
+      return *this;
+    }
+    
+    void evaluate()
+    {
+      ensureIsValid();
+      FEC_DGNodeEvaluate( getCRef() );
+      Exception::MaybeThrow();
+    }
+    
+    void setDependency(
+      char const *nameCString,
+      DGNode const &otherDGNode
+      )
+    {
+      ensureIsValid();
+      FEC_DGNodeSetDependency(
+        getCRef(),
+        nameCString,
+        otherDGNode.getCRef()
+        );
+      Exception::MaybeThrow();
+    }
+
+    void removeDependency(
+      char const *nameCString
+      )
+    {
+      ensureIsValid();
+      FEC_DGNodeRemoveDependency(
+        getCRef(),
+        nameCString
+        );
+      Exception::MaybeThrow();
+    }
+
+    void appendBinding( DGBinding const &dgBinding )
+    {
+      ensureIsValid();
+      FEC_DGNodeAppendBinding(
+        getCRef(),
+        dgBinding.getCRef()
+        );
+      Exception::MaybeThrow();
+
+    }
+
+    DGBindingList getBindingList()
+    {
+      ensureIsValid();
+      FEC_DGBindingListRef result = FEC_DGNodeGetBindingList(
+        getCRef()
+        );
+      Exception::MaybeThrow();
+      return DGBindingList( result );
+    }
+
+    Variant getDependencies_Variant()
+    {
+      ensureIsValid();
+      FEC_Variant result = FEC_DGNodeGetDependencies_Variant(
+        getCRef()
+        );
+      Exception::MaybeThrow();
+      return Variant( &result );
+    }
+
+    DGNode getDependency(
+      char const *nameCString
+      )
+    {
+      ensureIsValid();
+      FEC_DGNodeRef result = FEC_DGNodeGetDependency(
+        getCRef(),
+        nameCString
+        );
+      Exception::MaybeThrow();
+      return DGNode( result );
+    }
+
+    static DGNode GetByName(
+      Client const &client,
+      char const *nameCString
+      )
+    {
+      FEC_DGNamedObjectRef result = FEC_DGNamedObjectGetByName(
+        client.getCRef(),
+        nameCString,
+        "Node"
+        );
+      Exception::MaybeThrow();
+      return DGNode( result );
+    }
+  };
+  
+  class DGOperator : public DGContainer
+  {
+    friend class DGBinding;
+
+  protected:
+    
+    DGOperator( FEC_DGOperatorRef that )
+      : DGContainer( that )
+    {
+    }
+    
+  public:
+
+    DGOperator()
+    {
+    }
+    
+    DGOperator(
+      Client const &client,
+      char const *nameCString,
+      char const *filenameCString,
+      char const *sourceCodeCString,
+      char const *entryPointCString
+      )
+      : DGContainer( FEC_DGOperatorCreate(
+        client.getCRef(),
+        nameCString,
+        filenameCString,
+        sourceCodeCString,
+        entryPointCString
+        ) )
+    {
+    }
+    
+    DGOperator(
+      Client const &client,
+      char const *nameCString
+      )
+      : DGContainer( FEC_DGOperatorCreateEmpty(
+        client.getCRef(),
+        nameCString
+        ) )
+    {
+    }
+    
+    DGOperator( DGOperator const &that )
+      : DGContainer( that )
+    {
+    }
+    
+    DGOperator &operator =( DGOperator const &that )
+    {
+      set( that );
+      return *this;
+    }
+    
+    void setFilename(
+      char const *filenameCString
+      )
+    {
+      ensureIsValid();
+      FEC_DGOperatorSetFilename(
+        getCRef(),
+        filenameCString
+        );
+      Exception::MaybeThrow();
+    }
+
+    char const *getFilename()
+    {
+      ensureIsValid();
+      char const *str = FEC_DGOperatorGetFilename_cstr(
+        getCRef()
+        );
+      Exception::MaybeThrow();
+      return str;
+    }
+
+    void setSourceCode(
+      char const *sourceCodeCString
+      )
+    {
+      ensureIsValid();
+      FEC_DGOperatorSetSourceCode(
+        getCRef(),
+        sourceCodeCString
+        );
+      // the source may declare KL types
+      BumpRTGeneration();
+      Exception::MaybeThrow();
+    }
+
+    char const *getSourceCode()
+    {
+      ensureIsValid();
+      char const *str = FEC_DGOperatorGetSourceCode_cstr(
+        getCRef()
+        );
+      Exception::MaybeThrow();
+      return str;
+    }
+
+    void setEntryPoint(
+      char const *entryPointCString
+      )
+    {
+      ensureIsValid();
+      FEC_DGOperatorSetEntryPoint(
+        getCRef(),
+        entryPointCString
+        );
+      Exception::MaybeThrow();
+    }
+
+    const char *getEntryPoint()
+    {
+      ensureIsValid();
+      char const *str = FEC_DGOperatorGetEntryPoint_cstr(
+        getCRef()
+        );
+      Exception::MaybeThrow();
+      return str;
+    }
+
+    void setMainThreadOnly(
+      bool mainThreadOnly
+      )
+    {
+      ensureIsValid();
+      FEC_DGOperatorSetMainThreadOnly(
+        getCRef(),
+        mainThreadOnly
+        );
+      Exception::MaybeThrow();
+    }
+    
+    bool getMainThreadOnly()
+    {
+      ensureIsValid();
+      bool mainThreadOnly = FEC_DGOperatorGetMainThreadOnly( getCRef() );
+      Exception::MaybeThrow();
+      return mainThreadOnly;
+    }
+    
+    Variant getDiagnostics()
+    {
+      ensureIsValid();
+      FEC_DGCompiledObjectPrepareForExecution( getCRef() );
+      Exception::MaybeThrow();
+      
+      FEC_Variant result;
+      FEC_VariantInitWithDGOperatorGetDiagnostics( &result, getCRef() );
+      Exception::MaybeThrow();
+      return Variant( &result );
+    }
+    
+    static DGOperator GetByName(
+      Client const &client,
+      char const *nameCString
+      )
+    {
+      FEC_DGNamedObjectRef result = FEC_DGNamedObjectGetByName(
+        client.getCRef(),
+        nameCString,
+        "Operator"
+        );
+      Exception::MaybeThrow();
+      return DGOperator( result );
+    }
+  };
+  
+  inline DGBinding::DGBinding(
+    DGOperator const &dgOperator,
+    uint32_t parameterCount,
+    char const **parameters
+    )
+    : DGCompiledObject( FEC_DGBindingCreate(
+      dgOperator.getCRef(),
+      parameterCount,
+      parameters
+      ) )
+  {
+  }
+  
+  inline void DGBinding::setOperator( DGOperator const &dgOperator )
+  {
+    FEC_DGBindingSetOperator(
+      getCRef(),
+      dgOperator.getCRef()
+      );
+    Exception::MaybeThrow();
+  }
+  
+  inline DGOperator DGBinding::getOperator()
+  {
+    FEC_DGOperatorRef result = FEC_DGBindingGetOperator(
+      getCRef()
+      );
+    Exception::MaybeThrow();
+    return DGOperator( result );
+  }
+  
+  class DGEventHandler : public DGContainer
+  {
+  protected:
+    
+    DGEventHandler( FEC_DGEventHandlerRef that )
+      : DGContainer( that )
+    {
+    }
+    
+  public:
+    
+    DGEventHandler()
+    {
+    }
+    
+    DGEventHandler(
+      Client const &client,
+      char const *nameCString
+      )
+      : DGContainer( FEC_DGEventHandlerCreate(
+        client.getCRef(),
+        nameCString
+        ) )
+    {
+    }
+    
+    DGEventHandler( DGEventHandler const &that )
+      : DGContainer( that )
+    {
+    }
+    
+    DGEventHandler &operator =( DGEventHandler const &that )
+    {
+      set( that );
+      return *this;
+    }
+
+    void appendChildEventHandler( DGEventHandler const &dgChildEventHandler )
+    {
+      ensureIsValid();
+      FEC_DGEventHandlerAppendChildEventHandler(
+        getCRef(),
+        dgChildEventHandler.getCRef()
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+     
+    void removeChildEventHandler( DGEventHandler const &dgChildEventHandler )
+    {
+      ensureIsValid();
+      FEC_DGEventHandlerRemoveChildEventHandler(
+        getCRef(),
+        dgChildEventHandler.getCRef()
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+    
+    void appendPreDescendBinding( DGBinding const &dgBinding )
+    {
+      ensureIsValid();
+      FEC_DGEventHandlerAppendPreDescendBinding(
+        getCRef(),
+        dgBinding.getCRef()
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+
+    DGBindingList getPreDescendBindingList()
+    {
+      ensureIsValid();
+      FEC_DGBindingListRef result = FEC_DGEventHandlerGetPreDescendBindingList(
+        getCRef()
+        );
+      Exception::MaybeThrow();
+      return DGBindingList( result );
+    }
+
+    void appendPostDescendBinding( DGBinding const &dgBinding )
+    {
+      ensureIsValid();
+      FEC_DGEventHandlerAppendPostDescendBinding(
+        getCRef(),
+        dgBinding.getCRef()
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+    
+    DGBindingList getPostDescendBindingList()
+    {
+      ensureIsValid();
+      FEC_DGBindingListRef result = FEC_DGEventHandlerGetPostDescendBindingList(
+        getCRef()
+        );
+      Exception::MaybeThrow();
+      return DGBindingList( result );
+    }
+
+    void setScope(
+      char const *nameCString,
+      DGNode const &dgNode
+      )
+    {
+      ensureIsValid();
+      FEC_DGEventHandlerSetScope(
+        getCRef(),
+        nameCString,
+        dgNode.getCRef()
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+
+    void setScopeName(
+      char const *nameCString
+      )
+    {
+      ensureIsValid();
+      FEC_DGEventHandlerSetScopeName(
+        getCRef(),
+        nameCString
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+
+   char const *getScopeName()
+    {
+      ensureIsValid();
+      char const *str = FEC_DGEventHandlerGetScopeName_cstr(
+        getCRef()
+        );
+      Exception::MaybeThrow();
+      return str;
+    }
+
+    void setSelector(
+      char const *targetCString,
+      DGBinding const &dgBinding
+      )
+    {
+      ensureIsValid();
+      FEC_DGEventHandlerSetSelector(
+        getCRef(),
+        targetCString,
+        dgBinding.getCRef()
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+
+    static DGEventHandler GetByName(
+      Client const &client,
+      char const *nameCString
+      )
+    {
+      FEC_DGNamedObjectRef result = FEC_DGNamedObjectGetByName(
+        client.getCRef(),
+        nameCString,
+        "EventHandler"
+        );
+      Exception::MaybeThrow();
+      return DGEventHandler( result );
+    }
+
+    Variant getChildEventHandlers_Variant()
+    {
+      ensureIsValid();
+      FEC_Variant result = FEC_DGEventHandlerGetChildEventHandlers_Variant(
+        getCRef()
+        );
+      Exception::MaybeThrow();
+      return Variant( &result );
+    }
+
+    Variant getScopes_Variant()
+    {
+      ensureIsValid();
+      FEC_Variant result = FEC_DGEventHandlerGetScopes_Variant(
+        getCRef()
+        );
+      Exception::MaybeThrow();
+      return Variant( &result );
+    }
+
+    void removeScope(
+      char const *nameCString
+      )
+    {
+      ensureIsValid();
+      FEC_DGEventHandlerRemoveScope(
+        getCRef(),
+        nameCString
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+  };
+  
+  class DGEvent : public DGContainer
+  {
+  protected:
     
-    void setMemberSliceArraySize(
-      char const *memberCString,
-      uint32_t index,
-      uint32_t size
+    DGEvent( FEC_DGEventRef that )
+      : DGContainer( that )
+    {
+    }
+    
+  public:
+    
+    DGEvent()
+    {
+    }
+    
+    DGEvent(
+      Client const &client,
+      char const *nameCString
+      )
+      : DGContainer( FEC_DGEventCreate(
+        client.getCRef(),
+        nameCString
+        ) )
+    {
+    }
+    
+    DGEvent( DGEvent const &that )
+      : DGContainer( that )
+    {
+    }
+    
+    DGEvent &operator =( DGEvent const &that )
+    {
+      set( that );
+      return *this;
+    }
+
+    void removeEventHandler( DGEventHandler const &dgEventHandler )
+    {
+      ensureIsValid();
+      FEC_DGEventRemoveEventHandler(
+        getCRef(),
+        dgEventHandler.getCRef()
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+     
+    void appendEventHandler( DGEventHandler const &dgEventHandler )
+    {
+      ensureIsValid();
+      FEC_DGEventAppendEventHandler(
+        getCRef(),
+        dgEventHandler.getCRef()
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+    
+    void fire()
+    {
+      ensureIsValid();
+      FEC_DGEventFire(
+        getCRef()
+        );
+      Exception::MaybeThrow();
+    }
+
+    void setSelectType(
+      char const *typeCString
+      )
+    {
+      ensureIsValid();
+      FEC_DGEventSetSelectType(
+        getCRef(),
+        typeCString
+        );
+      Exception::MaybeThrow();
+      bumpWriteVersion();
+    }
+
+    char const *getSelectType()
+    {
+      ensureIsValid();
+      char const *str = FEC_DGEventGetSelectType(
+        getCRef()
+        );
+      Exception::MaybeThrow();
+      return str;
+    }
+
+    Variant select_Variant()
+    {
+      ensureIsValid();
+      FEC_Variant result;
+      FEC_VariantInitWithDGEventSelect(
+        getCRef(),
+        &result
+        );
+      Exception::MaybeThrow();
+      return Variant( &result );
+    }
+
+    Variant getEventHandlers_Variant()
+    {
+      ensureIsValid();
+      FEC_Variant result = FEC_DGEventGetEventHandlers_Variant(
+        getCRef()
+        );
+      Exception::MaybeThrow();
+      return Variant( &result );
+    }
+
+    static DGEvent GetByName(
+      Client const &client,
+      char const *nameCString
+      )
+    {
+      FEC_DGNamedObjectRef result = FEC_DGNamedObjectGetByName(
+        client.getCRef(),
+        nameCString,
+        "Event"
+        );
+      Exception::MaybeThrow();
+      return DGEvent( result );
+    }
+  };
+
+  /*!
+   * Bumps the write versions of the containers an evaluation or a fire
+   * made through DGSelectCache may write.  Nodes are followed through
+   * their dependencies, handlers through their child handlers and scopes;
+   * when a container can't be resolved every version is bumped instead.
+   */
+  class DGWriteReach
+  {
+    friend class DGSelectCache;
+
+    Client const &m_client;
+    StringPool m_visited;
+    bool m_complete;
+
+    DGWriteReach( DGWriteReach const & );
+    DGWriteReach &operator =( DGWriteReach const & );
+
+    DGWriteReach( Client const &client )
+      : m_client( client )
+      , m_complete( true )
+    {
+    }
+
+    // bumps the named container, returns false if it was already visited
+    bool visit( char const *name )
+    {
+      if ( m_visited.find( name ) )
+        return false;
+      m_visited.intern( name );
+      DGWriteVersions::Bump( name );
+      return true;
+    }
+
+    void addNode( DGNode &node )
+    {
+      if ( !node.isValid() )
+      {
+        m_complete = false;
+        return;
+      }
+      if ( !visit( node.getName() ) )
+        return;
+      Variant dependencies = node.getDependencies_Variant();
+      if ( dependencies.isDict() )
+      {
+        for ( Variant::DictIter it( dependencies ); !it.isDone(); it.next() )
+        {
+          DGNode dependency = node.getDependency( it.getKey()->getString_cstr() );
+          addNode( dependency );
+        }
+      }
+      else if ( dependencies.isArray() )
+      {
+        for ( uint32_t i=0; i<dependencies.getArraySize(); ++i )
+        {
+          Variant const *element = dependencies.getArrayElement( i );
+          if ( !element->isString() )
+            continue;
+          DGNode dependency = node.getDependency( element->getString_cstr() );
+          addNode( dependency );
+        }
+      }
+    }
+
+    void addHandlers( Variant const &names )
+    {
+      if ( names.isDict() )
+      {
+        for ( Variant::DictIter it( names ); !it.isDone(); it.next() )
+          addHandler( it.getKey()->getString_cstr() );
+      }
+      else if ( names.isArray() )
+      {
+        for ( uint32_t i=0; i<names.getArraySize(); ++i )
+        {
+          if ( names.getArrayElement( i )->isString() )
+            addHandler( names.getArrayElement( i )->getString_cstr() );
+        }
+      }
+    }
+
+    void addHandler( char const *name )
+    {
+      DGEventHandler handler = DGEventHandler::GetByName( m_client, name );
+      if ( !handler.isValid() )
+      {
+        m_complete = false;
+        return;
+      }
+      if ( !visit( name ) )
+        return;
+      Variant scopes = handler.getScopes_Variant();
+      if ( scopes.isDict() )
+      {
+        for ( Variant::DictIter it( scopes ); !it.isDone(); it.next() )
+        {
+          if ( !it.getValue()->isString() )
+          {
+            m_complete = false;
+            continue;
+          }
+          DGNode node = DGNode::GetByName( m_client, it.getValue()->getString_cstr() );
+          addNode( node );
+        }
+      }
+      addHandlers( handler.getChildEventHandlers_Variant() );
+    }
+
+    // falls back to BumpAll() if any container couldn't be resolved
+    void finish()
+    {
+      if ( !m_complete )
+        DGWriteVersions::BumpAll();
+    }
+
+    static void Node( DGNode &node, Client const &client )
+    {
+      DGWriteReach reach( client );
+      try
+      {
+        reach.addNode( node );
+      }
+      catch ( Exception const & )
+      {
+        reach.m_complete = false;
+      }
+      reach.finish();
+    }
+
+    static void Event( DGEvent &event, Client const &client )
+    {
+      DGWriteReach reach( client );
+      try
+      {
+        reach.visit( event.getName() );
+        reach.addHandlers( event.getEventHandlers_Variant() );
+      }
+      catch ( Exception const & )
+      {
+        reach.m_complete = false;
+      }
+      reach.finish();
+    }
+  };
+
+  /*
+   * C++ - DG Scheduling
+   */
+
+  /*!
+   * Evaluates a DGNode after evaluating its upstream nodes in parallel.
+   *
+   * The graph reachable through DGNode::setDependency is gathered and
+   * topologically ordered.  Nodes whose dependencies have all been
+   * evaluated run concurrently on a work-stealing TaskPool, and the
+   * target node is evaluated last on the calling thread.
+   *
+   * Nodes bound to a main-thread-only operator are queued for the calling
+   * thread and run back to back there, while parallel-safe nodes keep the
+   * other threads busy.  This only overlaps anything with concurrent
+   * evaluation enabled; by default all evaluations are serialized anyway.
+   * The tag is per node, since FEC_DGNodeEvaluate runs a node's whole
+   * binding list: one main-thread-only operator pins every other operator
+   * of its node to the calling thread as well.  The offending operators
+   * are reported through getSerializingOperatorName().  Nodes downstream
+   * of a node that failed are skipped.
+   *
+   * By default the FEC_DGNodeEvaluate calls, and the last-exception checks
+   * that follow them, are serialized through a process wide mutex, so
+   * only the gathering and ordering is done here.  Running them
+   * concurrently with setConcurrentEvaluation( true ) requires a runtime
+   * whose FEC_DGNodeEvaluate is reentrant across nodes and whose last
+   * exception is kept per thread; neither is documented by the C API.
+   */
+  class DGScheduler
+  {
+  public:
+
+    struct Stats
+    {
+      uint32_t nodeCount;
+      // number of nodes on the longest dependency chain, target included
+      uint32_t criticalPathLength;
+      uint32_t threadCount;
+      uint64_t stealCount;
+      double wallSeconds;
+      double busySeconds;
+      // nodeCount / criticalPathLength, the best speedup the graph allows
+      double availableParallelism;
+      // busySeconds / wallSeconds, the speedup actually achieved.  Time spent
+      // waiting for the evaluation mutex doesn't count as busy
+      double achievedParallelism;
+      // true if the evaluations were serialized, see setConcurrentEvaluation()
+      bool serialized;
+      // nodes that had to run on the calling thread, and the time they took.
+      // unless the evaluations ran concurrently, they cost nothing extra
+      uint32_t mainThreadNodeCount;
+      double mainThreadSeconds;
+      // nodes not evaluated because a node upstream of them failed
+      uint32_t skippedNodeCount;
+    };
+
+  private:
+
+    struct Entry
+    {
+      DGScheduler *scheduler;
+      DGNode node;
+      char const *name;
+      uint32_t *dependents;
+      uint32_t dependentCount;
+      uint32_t remaining;
+      uint32_t depth;
+      bool mainThreadOnly;
+      bool skipped;
+    };
+
+    TaskPool m_pool;
+    Entry **m_entries;
+    uint32_t m_count;
+    uint32_t m_capacity;
+    uint32_t *m_buckets;
+    uint32_t m_bucketMask;
+    StringPool *m_names;
+    Mutex m_mutex;
+    bool m_concurrent;
+    bool m_failed;
+    SmallString m_error;
+    double m_busySeconds;
+    double m_mainThreadSeconds;
+    char const **m_serializing;
+    uint32_t m_serializingCount;
+    Stats m_stats;
+
+    DGScheduler( DGScheduler const & );
+    DGScheduler &operator =( DGScheduler const & );
+
+    void reset()
+    {
+      for ( uint32_t i=0; i<m_count; ++i )
+      {
+        free( m_entries[i]->dependents );
+        delete m_entries[i];
+      }
+      free( m_entries );
+      m_entries = 0;
+      m_count = 0;
+      m_capacity = 0;
+      free( m_buckets );
+      m_buckets = 0;
+      m_bucketMask = 0;
+      free( m_serializing );
+      m_serializing = 0;
+      m_serializingCount = 0;
+      delete m_names;
+      m_names = 0;
+    }
+
+    static void addDependent( Entry *entry, uint32_t dependent )
+    {
+      for ( uint32_t i=0; i<entry->dependentCount; ++i )
+      {
+        if ( entry->dependents[i] == dependent )
+          return;
+      }
+      entry->dependents = (uint32_t *)realloc(
+        entry->dependents, ( entry->dependentCount + 1 ) * sizeof(uint32_t)
+        );
+      entry->dependents[entry->dependentCount++] = dependent;
+    }
+
+    static uint32_t HashHandle( char const *handle )
+    {
+      size_t value = size_t( handle );
+      return uint32_t( value ^ ( value >> 16 ) ) * 2654435761u;
+    }
+
+    // returns the bucket holding the entry of an interned name, or the
+    // empty bucket it would go into
+    uint32_t findBucket( char const *name ) const
+    {
+      uint32_t bucket = HashHandle( name ) & m_bucketMask;
+      while ( m_buckets[bucket] && m_entries[m_buckets[bucket] - 1]->name != name )
+        bucket = ( bucket + 1 ) & m_bucketMask;
+      return bucket;
+    }
+
+    void grow()
+    {
+      uint32_t capacity = m_capacity ? m_capacity * 2 : 64;
+      Entry **entries = (Entry **)realloc( m_entries, capacity * sizeof(Entry *) );
+      uint32_t *buckets = (uint32_t *)calloc( capacity * 2, sizeof(uint32_t) );
+      if ( entries )
+        m_entries = entries;
+      if ( !entries || !buckets )
+      {
+        free( buckets );
+        Exception::Throw( "DGScheduler: out of memory" );
+      }
+      m_capacity = capacity;
+      free( m_buckets );
+      m_buckets = buckets;
+      m_bucketMask = capacity * 2 - 1;
+      for ( uint32_t i=0; i<m_count; ++i )
+        m_buckets[findBucket( m_entries[i]->name )] = i + 1;
+    }
+
+    uint32_t gather( DGNode const &node )
+    {
+      char const *name = m_names->intern( node.getName() );
+      if ( m_buckets )
+      {
+        uint32_t slot = m_buckets[findBucket( name )];
+        if ( slot )
+          return slot - 1;
+      }
+
+      if ( m_count == m_capacity )
+        grow();
+      Entry *entry = new Entry;
+      entry->scheduler = this;
+      entry->node = node;
+      entry->name = name;
+      entry->dependents = 0;
+      entry->dependentCount = 0;
+      entry->remaining = 0;
+      entry->depth = 0;
+      entry->mainThreadOnly = false;
+      entry->skipped = false;
+      uint32_t index = m_count++;
+      m_entries[index] = entry;
+      m_buckets[findBucket( name )] = index + 1;
+
+      DGBindingList bindingList = entry->node.getBindingList();
+      for ( uint32_t i=0; i<bindingList.getCount(); ++i )
+      {
+        DGOperator op = bindingList.getBinding( i ).getOperator();
+        if ( op.isValid() && op.getMainThreadOnly() )
+        {
+          entry->mainThreadOnly = true;
+          addSerializing( m_names->intern( op.getName() ) );
+        }
+      }
+
+      Variant dependencies = entry->node.getDependencies_Variant();
+      if ( dependencies.isDict() )
+      {
+        for ( Variant::DictIter it( dependencies ); !it.isDone(); it.next() )
+          addDependency( index, it.getKey()->getString_cstr() );
+      }
+      else if ( dependencies.isArray() )
+      {
+        for ( uint32_t i=0; i<dependencies.getArraySize(); ++i )
+        {
+          Variant const *element = dependencies.getArrayElement( i );
+          if ( element->isString() )
+            addDependency( index, element->getString_cstr() );
+        }
+      }
+      return index;
+    }
+
+    void addSerializing( char const *operatorName )
+    {
+      for ( uint32_t i=0; i<m_serializingCount; ++i )
+      {
+        if ( m_serializing[i] == operatorName )
+          return;
+      }
+      m_serializing = (char const **)realloc(
+        m_serializing, ( m_serializingCount + 1 ) * sizeof(char const *)
+        );
+      m_serializing[m_serializingCount++] = operatorName;
+    }
+
+    // main-thread-only is decided per node, so the whole binding list of a
+    // node with one such operator runs on the calling thread
+    void schedule( Entry *entry )
+    {
+      if ( entry->mainThreadOnly )
+        m_pool.submitMain( &EvaluateTask, entry );
+      else
+        m_pool.submit( &EvaluateTask, entry );
+    }
+
+    void addDependency( uint32_t index, char const *dependencyName )
+    {
+      DGNode dependency = m_entries[index]->node.getDependency( dependencyName );
+      if ( !dependency.isValid() )
+        return;
+      uint32_t dependencyIndex = gather( dependency );
+      uint32_t before = m_entries[dependencyIndex]->dependentCount;
+      addDependent( m_entries[dependencyIndex], index );
+      if ( m_entries[dependencyIndex]->dependentCount != before )
+        ++m_entries[index]->remaining;
+    }
+
+    // computes the depth of every node, returns the critical path length
+    uint32_t order()
+    {
+      uint32_t *remaining = (uint32_t *)malloc( m_count * sizeof(uint32_t) );
+      uint32_t *queue = (uint32_t *)malloc( m_count * sizeof(uint32_t) );
+      uint32_t head = 0, tail = 0;
+      for ( uint32_t i=0; i<m_count; ++i )
+      {
+        remaining[i] = m_entries[i]->remaining;
+        m_entries[i]->depth = 1;
+        if ( remaining[i] == 0 )
+          queue[tail++] = i;
+      }
+      uint32_t criticalPathLength = 0;
+      while ( head < tail )
+      {
+        Entry *entry = m_entries[queue[head++]];
+        if ( entry->depth > criticalPathLength )
+          criticalPathLength = entry->depth;
+        for ( uint32_t i=0; i<entry->dependentCount; ++i )
+        {
+          Entry *dependent = m_entries[entry->dependents[i]];
+          if ( dependent->depth < entry->depth + 1 )
+            dependent->depth = entry->depth + 1;
+          if ( --remaining[entry->dependents[i]] == 0 )
+            queue[tail++] = entry->dependents[i];
+        }
+      }
+      free( remaining );
+      free( queue );
+      if ( tail != m_count )
+        Exception::Throw( "DGScheduler: the dependency graph contains a cycle" );
+      return criticalPathLength;
+    }
+
+    static void EvaluateTask( void *userdata )
+    {
+      Entry *entry = static_cast<Entry *>( userdata );
+      entry->scheduler->evaluateEntry( entry );
+    }
+
+    static Mutex &EvaluationMutex()
+    {
+      static Mutex mutex;
+      return mutex;
+    }
+
+    void evaluateEntry( Entry *entry )
+    {
+      // dependents of a failed or skipped node are only passed through,
+      // so that the skip reaches everything downstream
+      bool skipped;
+      {
+        MutexLock lock( m_mutex );
+        skipped = entry->skipped;
+      }
+      // only the evaluation itself is timed, not the wait for the mutex
+      double start = 0.0;
+      bool failed = false;
+      SmallString error;
+      if ( !skipped )
+      {
+        try
+        {
+          if ( m_concurrent )
+          {
+            start = GetSeconds();
+            entry->node.evaluate();
+          }
+          else
+          {
+            MutexLock lock( EvaluationMutex() );
+            start = GetSeconds();
+            entry->node.evaluate();
+          }
+        }
+        catch ( Exception const &e )
+        {
+          failed = true;
+          error.assign( e.getDescData(), e.getDescLength() );
+        }
+        catch ( ... )
+        {
+          failed = true;
+          static char const message[] = "DGScheduler: unknown exception";
+          error.assign( message, sizeof(message) - 1 );
+        }
+      }
+      double seconds = skipped ? 0.0 : GetSeconds() - start;
+
+      uint32_t ready[16];
+      uint32_t readyCount = 0;
+      MutexLock lock( m_mutex );
+      m_busySeconds += seconds;
+      if ( entry->mainThreadOnly )
+        m_mainThreadSeconds += seconds;
+      if ( failed && !m_failed )
+      {
+        m_failed = true;
+        m_error = error;
+      }
+      if ( skipped )
+        ++m_stats.skippedNodeCount;
+      for ( uint32_t i=0; i<entry->dependentCount; ++i )
+      {
+        uint32_t dependent = entry->dependents[i];
+        if ( failed || skipped )
+          m_entries[dependent]->skipped = true;
+        if ( --m_entries[dependent]->remaining == 0 && dependent != 0 )
+        {
+          if ( readyCount == 16 )
+          {
+            for ( uint32_t j=0; j<readyCount; ++j )
+              schedule( m_entries[ready[j]] );
+            readyCount = 0;
+          }
+          ready[readyCount++] = dependent;
+        }
+      }
+      for ( uint32_t j=0; j<readyCount; ++j )
+        schedule( m_entries[ready[j]] );
+    }
+
+  public:
+
+    /*!
+     * Creates a scheduler with the given number of background threads.
+     * The default uses one thread per core.
+     */
+    DGScheduler( uint32_t threadCount = 0xffffffffu )
+      : m_pool( threadCount )
+      , m_entries( 0 )
+      , m_count( 0 )
+      , m_capacity( 0 )
+      , m_buckets( 0 )
+      , m_bucketMask( 0 )
+      , m_names( 0 )
+      , m_concurrent( false )
+      , m_failed( false )
+      , m_busySeconds( 0.0 )
+      , m_mainThreadSeconds( 0.0 )
+      , m_serializing( 0 )
+      , m_serializingCount( 0 )
+    {
+      memset( &m_stats, 0, sizeof(m_stats) );
+    }
+
+    ~DGScheduler()
+    {
+      reset();
+    }
+
+    /*!
+     * Lets nodes be evaluated concurrently instead of one at a time.  Only
+     * enable this for a runtime known to support it, see above.
+     */
+    void setConcurrentEvaluation( bool concurrent )
+    {
+      m_concurrent = concurrent;
+    }
+
+    bool getConcurrentEvaluation() const
+    {
+      return m_concurrent;
+    }
+
+    void evaluate( DGNode const &target )
+    {
+      reset();
+      m_names = new StringPool;
+      m_failed = false;
+      m_busySeconds = 0.0;
+      m_mainThreadSeconds = 0.0;
+      m_stats.skippedNodeCount = 0;
+      uint64_t stealCount = m_pool.getStealCount();
+      double start = GetSeconds();
+
+      gather( target );
+      uint32_t criticalPathLength = order();
+
+      // the target is entry 0 and runs last, on the calling thread
+      for ( uint32_t i=1; i<m_count; ++i )
+      {
+        if ( m_entries[i]->remaining == 0 )
+          schedule( m_entries[i] );
+      }
+      m_pool.wait();
+      if ( !m_failed && !m_entries[0]->skipped )
+        evaluateEntry( m_entries[0] );
+      else
+        ++m_stats.skippedNodeCount;
+
+      m_stats.nodeCount = m_count;
+      m_stats.criticalPathLength = criticalPathLength;
+      m_stats.threadCount = m_pool.getThreadCount();
+      m_stats.stealCount = m_pool.getStealCount() - stealCount;
+      m_stats.wallSeconds = GetSeconds() - start;
+      m_stats.busySeconds = m_busySeconds;
+      m_stats.availableParallelism = criticalPathLength > 0
+        ? double( m_count ) / double( criticalPathLength ) : 0.0;
+      m_stats.achievedParallelism = m_stats.wallSeconds > 0.0
+        ? m_busySeconds / m_stats.wallSeconds : 0.0;
+      m_stats.serialized = !m_concurrent;
+      m_stats.mainThreadNodeCount = 0;
+      for ( uint32_t i=0; i<m_count; ++i )
+      {
+        if ( m_entries[i]->mainThreadOnly )
+          ++m_stats.mainThreadNodeCount;
+      }
+      m_stats.mainThreadSeconds = m_mainThreadSeconds;
+
+      if ( m_failed )
+        Exception::Throw( m_error.getCString() );
+    }
+
+    Stats const &getStats() const
+    {
+      return m_stats;
+    }
+
+    // operators of the last evaluation that forced work onto the
+    // calling thread
+    uint32_t getSerializingOperatorCount() const
+    {
+      return m_serializingCount;
+    }
+
+    char const *getSerializingOperatorName( uint32_t index ) const
+    {
+      return m_serializing[index];
+    }
+
+    Variant getStats_Variant() const
+    {
+      Variant result = Variant::CreateDict();
+      result.setDictValue( "nodeCount", Variant::CreateUInt32( m_stats.nodeCount ) );
+      result.setDictValue( "criticalPathLength", Variant::CreateUInt32( m_stats.criticalPathLength ) );
+      result.setDictValue( "threadCount", Variant::CreateUInt32( m_stats.threadCount ) );
+      result.setDictValue( "stealCount", Variant::CreateUInt64( m_stats.stealCount ) );
+      result.setDictValue( "wallSeconds", Variant::CreateFloat64( m_stats.wallSeconds ) );
+      result.setDictValue( "busySeconds", Variant::CreateFloat64( m_stats.busySeconds ) );
+      result.setDictValue( "availableParallelism", Variant::CreateFloat64( m_stats.availableParallelism ) );
+      result.setDictValue( "achievedParallelism", Variant::CreateFloat64( m_stats.achievedParallelism ) );
+      result.setDictValue( "mainThreadNodeCount", Variant::CreateUInt32( m_stats.mainThreadNodeCount ) );
+      result.setDictValue( "mainThreadSeconds", Variant::CreateFloat64( m_stats.mainThreadSeconds ) );
+      result.setDictValue( "skippedNodeCount", Variant::CreateUInt32( m_stats.skippedNodeCount ) );
+      Variant serializing = Variant::CreateArray();
+      for ( uint32_t i=0; i<m_serializingCount; ++i )
+        serializing.arrayAppend( Variant::CreateString( m_serializing[i] ) );
+      result.setDictValue( "serializingOperators", serializing );
+      return result;
+    }
+  };
+
+  /*
+   * C++ - DG Operator Fusion
+   */
+
+  /*!
+   * Merges runs of consecutive per-slice operators in a DGNode's binding
+   * list into a single operator, so that every slice is read and written
+   * once per run instead of once per operator.
+   *
+   * An operator takes part when every parameter of its binding is a plain
+   * "self.member" of the node and it is not main-thread only.  The sources
+   * of a run are split into their top level declarations, skipping comments
+   * and string literals; each entry operator becomes a function called in
+   * binding order, require statements are hoisted and declarations shared
+   * verbatim are emitted once.  A run whose sources declare the same name
+   * differently, or whose fused operator fails to compile, is left
+   * unchanged.  Operators produced by fusion never take part again, so
+   * fuse() can be called repeatedly.  Fusion is opt-in and can be undone
+   * with restore().
+   */
+  class DGOperatorFuser
+  {
+    class Text
+    {
+      char *m_data;
+      uint32_t m_length;
+      uint32_t m_capacity;
+
+      Text( Text const & );
+      Text &operator =( Text const & );
+
+    public:
+
+      Text()
+        : m_data( 0 )
+        , m_length( 0 )
+        , m_capacity( 0 )
+      {
+        append( "", 0 );
+      }
+
+      ~Text()
+      {
+        free( m_data );
+      }
+
+      void append( char const *data, uint32_t length )
+      {
+        if ( m_length + length + 1 > m_capacity )
+        {
+          uint32_t capacity = ( m_length + length + 1 ) * 2;
+          char *grown = (char *)realloc( m_data, capacity );
+          if ( !grown )
+            Exception::Throw( "DGOperatorFuser: out of memory" );
+          m_data = grown;
+          m_capacity = capacity;
+        }
+        memcpy( m_data + m_length, data, length );
+        m_length += length;
+        m_data[m_length] = '\0';
+      }
+
+      void append( char const *cString )
+      {
+        append( cString, uint32_t( strlen( cString ) ) );
+      }
+
+      void append( uint32_t value )
+      {
+        char buffer[16];
+        sprintf( buffer, "%u", unsigned( value ) );
+        append( buffer );
+      }
+
+      char const *getCString() const
+      {
+        return m_data;
+      }
+    };
+
+    struct Saved
+    {
+      DGNode node;
+      DGBinding *bindings;
+      uint32_t count;
+    };
+
+    Client m_client;
+    Saved **m_saved;
+    uint32_t m_savedCount;
+    DGOperator **m_operators;
+    uint32_t m_operatorCount;
+    uint32_t m_fusedPassCount;
+    uint32_t m_nextId;
+
+    DGOperatorFuser( DGOperatorFuser const & );
+    DGOperatorFuser &operator =( DGOperatorFuser const & );
+
+    static bool IsIdentifierChar( char c )
+    {
+      return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' )
+        || ( c >= '0' && c <= '9' ) || c == '_';
+    }
+
+    static char const *SkipSpace( char const *p )
+    {
+      while ( *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' )
+        ++p;
+      return p;
+    }
+
+    // a top level declaration of a KL source
+    struct Item
+    {
+      char const *begin;
+      char const *end;
+      // the declared name, "Type.method" for methods, interned
+      char const *name;
+      // where the declared name ends in the source
+      char const *nameEnd;
+      bool isRequire;
+      bool isOperator;
+    };
+
+    static char const *SkipIgnored( char const *p )
+    {
+      for ( ;; )
+      {
+        p = SkipSpace( p );
+        if ( p[0] == '/' && p[1] == '/' )
+        {
+          while ( *p && *p != '\n' )
+            ++p;
+        }
+        else if ( p[0] == '/' && p[1] == '*' )
+        {
+          p += 2;
+          while ( *p && !( p[0] == '*' && p[1] == '/' ) )
+            ++p;
+          if ( !*p )
+            return 0;
+          p += 2;
+        }
+        else
+          return p;
+      }
+    }
+
+    // p points at the opening quote, returns the position after the
+    // closing one or 0 if the literal is unterminated
+    static char const *SkipLiteral( char const *p )
+    {
+      char quote = *p++;
+      while ( *p && *p != quote && *p != '\n' )
+      {
+        if ( *p == '\\' && p[1] )
+          ++p;
+        ++p;
+      }
+      return *p == quote ? p + 1 : 0;
+    }
+
+    static bool IsKeyword( char const *begin, char const *end, char const *keyword )
+    {
+      size_t length = strlen( keyword );
+      return size_t( end - begin ) == length && strncmp( begin, keyword, length ) == 0;
+    }
+
+    /*!
+     * Splits a KL source into its top level declarations, skipping comments
+     * and string literals.  The name of a declaration is the identifier
+     * after struct, object, interface or operator, or otherwise the last
+     * identifier before its first top level '(', '=' or '{', or before its
+     * terminating ';'.  Returns false if the source doesn't parse.
+     */
+    static bool ParseItems(
+      char const *source,
+      StringPool &names,
+      Item *&items,
+      uint32_t &itemCount
+      )
+    {
+      items = 0;
+      itemCount = 0;
+      uint32_t capacity = 0;
+      char const *p = SkipIgnored( source );
+      while ( p && *p )
+      {
+        Item item;
+        item.begin = p;
+        item.name = 0;
+        item.nameEnd = 0;
+        item.isRequire = false;
+        item.isOperator = false;
+
+        uint32_t depth = 0;
+        uint32_t identCount = 0;
+        char const *identBegin = 0;
+        char const *identEnd = 0;
+        bool nameNext = false;
+        bool done = false;
+        while ( !done )
+        {
+          p = SkipIgnored( p );
+          if ( !p || !*p )
+          {
+            free( items );
+            return false;
+          }
+          char c = *p;
+          if ( IsIdentifierChar( c ) )
+          {
+            char const *begin = p;
+            while ( IsIdentifierChar( *p ) )
+              ++p;
+            if ( depth > 0 || item.name )
+              continue;
+            if ( identCount++ == 0 )
+            {
+              item.isRequire = IsKeyword( begin, p, "require" );
+              item.isOperator = IsKeyword( begin, p, "operator" );
+              nameNext = item.isOperator
+                || IsKeyword( begin, p, "struct" )
+                || IsKeyword( begin, p, "object" )
+                || IsKeyword( begin, p, "interface" );
+            }
+            else if ( nameNext )
+            {
+              item.name = names.intern( begin, uint32_t( p - begin ) );
+              item.nameEnd = p;
+            }
+            identBegin = begin;
+            identEnd = p;
+          }
+          else if ( c == '"' || c == '\'' )
+          {
+            p = SkipLiteral( p );
+            if ( !p )
+            {
+              free( items );
+              return false;
+            }
+          }
+          else
+          {
+            if ( depth == 0 && !item.name && identEnd
+              && ( c == '(' || c == '=' || c == '{' || c == ';' ) )
+            {
+              char const *begin = identBegin;
+              if ( begin - 1 > item.begin && begin[-1] == '.' )
+              {
+                begin -= 1;
+                while ( begin > item.begin && IsIdentifierChar( begin[-1] ) )
+                  --begin;
+              }
+              item.name = names.intern( begin, uint32_t( identEnd - begin ) );
+              item.nameEnd = identEnd;
+            }
+            ++p;
+            if ( c == '(' || c == '[' || c == '{' )
+              ++depth;
+            else if ( c == ')' || c == ']' || c == '}' )
+            {
+              if ( depth == 0 )
+              {
+                free( items );
+                return false;
+              }
+              done = --depth == 0 && c == '}';
+            }
+            else if ( c == ';' && depth == 0 )
+              done = true;
+          }
+        }
+        item.end = p;
+
+        if ( itemCount == capacity )
+        {
+          capacity = capacity ? capacity * 2 : 16;
+          Item *grown = (Item *)realloc( items, capacity * sizeof(Item) );
+          if ( !grown )
+          {
+            free( items );
+            Exception::Throw( "DGOperatorFuser: out of memory" );
+          }
+          items = grown;
+        }
+        items[itemCount++] = item;
+        p = SkipIgnored( p );
+      }
+      if ( !p )
+      {
+        free( items );
+        return false;
+      }
+      return true;
+    }
+
+    // operators created by a fuser, which are never fused again
+    static bool IsFused( DGOperator &op )
+    {
+      return strcmp( op.getEntryPoint(), "fusedEntry" ) == 0
+        && strstr( op.getName(), "__fused" ) != 0;
+    }
+
+    // fetches the parameter layout of a per-slice binding, or returns false
+    // if the binding cannot take part in a fused pass
+    static bool GetSliceMembers(
+      DGNode &node,
+      DGBinding &binding,
+      Variant &layout
+      )
+    {
+      DGOperator op = binding.getOperator();
+      if ( op.getMainThreadOnly() || IsFused( op ) )
+        return false;
+      layout = binding.getParameterLayout_Variant();
+      if ( !layout.isArray() )
+        return false;
+      for ( uint32_t i=0; i<layout.getArraySize(); ++i )
+      {
+        Variant const *parameter = layout.getArrayElement( i );
+        if ( !parameter->isString() )
+          return false;
+        char const *data = parameter->getStringData();
+        uint32_t length = parameter->getStringLength();
+        if ( length <= 5 || strncmp( data, "self.", 5 ) != 0 )
+          return false;
+        for ( uint32_t j=5; j<length; ++j )
+        {
+          if ( !IsIdentifierChar( data[j] ) )
+            return false;
+        }
+        node.getMemberType( data + 5 );
+      }
+      return true;
+    }
+
+    static bool HasErrors( Variant const &errors )
+    {
+      if ( errors.isArray() )
+        return errors.getArraySize() > 0;
+      if ( errors.isDict() )
+        return !Variant::DictIter( errors ).isDone();
+      return false;
+    }
+
+    struct Declaration
+    {
+      // interned name, 0 for require statements
+      char const *name;
+      // interned text of the declaration
+      char const *text;
+      uint32_t function;
+    };
+
+    /*!
+     * Appends the declarations of an operator's source, with its entry
+     * operator turned into the function fused<function>_ and its require
+     * statements hoisted.  Declarations repeated verbatim by several
+     * sources are only emitted once.  Returns false if the source doesn't
+     * parse, lacks a unique entry operator, or declares a name that another
+     * source of the run declares differently.
+     */
+    static bool AppendSource(
+      char const *source,
+      char const *entryPoint,
+      uint32_t function,
+      StringPool &pool,
+      Declaration *&declared,
+      uint32_t &declaredCount,
+      Text &requirements,
+      Text &declarations
+      )
+    {
+      Item *items;
+      uint32_t itemCount;
+      if ( !ParseItems( source, pool, items, itemCount ) )
+        return false;
+
+      char const *entryName = pool.intern( entryPoint );
+      uint32_t entryCount = 0;
+      for ( uint32_t i=0; i<itemCount; ++i )
+      {
+        if ( items[i].isOperator && items[i].name == entryName )
+          ++entryCount;
+      }
+
+      bool ok = entryCount == 1;
+      for ( uint32_t i=0; ok && i<itemCount; ++i )
+      {
+        Item const &item = items[i];
+        if ( item.isOperator && item.name == entryName )
+        {
+          declarations.append( "function fused" );
+          declarations.append( function );
+          declarations.append( "_" );
+          declarations.append( item.nameEnd, uint32_t( item.end - item.nameEnd ) );
+          declarations.append( "\n" );
+          continue;
+        }
+
+        char const *name = item.isRequire ? 0 : item.name;
+        char const *text = pool.intern( item.begin, uint32_t( item.end - item.begin ) );
+        bool duplicate = false;
+        for ( uint32_t j=0; j<declaredCount; ++j )
+        {
+          if ( declared[j].name != name )
+            continue;
+          if ( declared[j].text == text )
+            duplicate = true;
+          else if ( name && declared[j].function != function )
+            ok = false;
+        }
+        if ( duplicate || !ok )
+          continue;
+
+        Declaration *grown = (Declaration *)realloc( declared, ( declaredCount + 1 ) * sizeof(Declaration) );
+        if ( !grown )
+        {
+          free( items );
+          Exception::Throw( "DGOperatorFuser: out of memory" );
+        }
+        declared = grown;
+        declared[declaredCount].name = name;
+        declared[declaredCount].text = text;
+        declared[declaredCount].function = function;
+        ++declaredCount;
+
+        Text &target = item.isRequire ? requirements : declarations;
+        target.append( text );
+        target.append( "\n" );
+      }
+      free( items );
+      return ok;
+    }
+
+    bool fuseRun(
+      DGNode &node,
+      DGBindingList &bindingList,
+      uint32_t start,
+      uint32_t count
       )
     {
-      ensureIsValid();
-      FEC_DGContainerSetMemberSliceArraySize(
-        getCRef(),
-        memberCString,
-        index,
-        size
-        );
-      Exception::MaybeThrow();
+      char const *nodeName = node.getName();
+      uint32_t id = m_nextId++;
+
+      Text source;
+      Text declarations;
+      Text body;
+      StringPool pool;
+      Declaration *declared = 0;
+      uint32_t declaredCount = 0;
+      StringPool members;
+      char const **memberList = 0;
+      uint32_t memberCount = 0;
+      char const **operatorNames = (char const **)malloc( count * sizeof(char const *) );
+      uint32_t operatorCount = 0;
+      if ( !operatorNames )
+        Exception::Throw( "DGOperatorFuser: out of memory" );
+
+      bool ok = true;
+      for ( uint32_t i=0; ok && i<count; ++i )
+      {
+        DGBinding binding = bindingList.getBinding( start + i );
+        DGOperator op = binding.getOperator();
+        Variant parameterLayout = binding.getParameterLayout_Variant();
+
+        uint32_t function = 0;
+        char const *opName = pool.intern( op.getName() );
+        while ( function < operatorCount && operatorNames[function] != opName )
+          ++function;
+        if ( function == operatorCount )
+        {
+          if ( !AppendSource(
+            op.getSourceCode(),
+            op.getEntryPoint(),
+            function,
+            pool,
+            declared,
+            declaredCount,
+            source,
+            declarations
+            ) )
+          {
+            ok = false;
+            break;
+          }
+          operatorNames[operatorCount++] = opName;
+        }
+
+        body.append( "  fused" );
+        body.append( function );
+        body.append( "_(" );
+        for ( uint32_t j=0; j<parameterLayout.getArraySize(); ++j )
+        {
+          Variant const *parameter = parameterLayout.getArrayElement( j );
+          char const *member = members.find( parameter->getStringData() + 5, parameter->getStringLength() - 5 );
+          if ( !member )
+          {
+            member = members.intern( parameter->getStringData() + 5, parameter->getStringLength() - 5 );
+            char const **grown = (char const **)realloc( memberList, ( memberCount + 1 ) * sizeof(char const *) );
+            if ( !grown )
+            {
+              ok = false;
+              break;
+            }
+            memberList = grown;
+            memberList[memberCount++] = member;
+          }
+          if ( j > 0 )
+            body.append( ", " );
+          body.append( member );
+        }
+        body.append( ");\n" );
+      }
+
+      if ( ok )
+      {
+        Text parameters;
+        char const **layout = (char const **)malloc( memberCount * sizeof(char const *) );
+        Text *layoutStrings = new Text[memberCount];
+        for ( uint32_t i=0; i<memberCount; ++i )
+        {
+          if ( i > 0 )
+            parameters.append( ", " );
+          parameters.append( "io " );
+          parameters.append( node.getMemberType( memberList[i] ) );
+          parameters.append( " " );
+          parameters.append( memberList[i] );
+          layoutStrings[i].append( "self." );
+          layoutStrings[i].append( memberList[i] );
+          layout[i] = layoutStrings[i].getCString();
+        }
+        source.append( declarations.getCString() );
+        source.append( "operator fusedEntry(" );
+        source.append( parameters.getCString() );
+        source.append( ") {\n" );
+        source.append( body.getCString() );
+        source.append( "}\n" );
+
+        Text name;
+        name.append( nodeName );
+        name.append( "__fused" );
+        name.append( id );
+
+        DGOperator fusedOperator;
+        try
+        {
+          fusedOperator = DGOperator(
+            m_client,
+            name.getCString(),
+            "fused.kl",
+            source.getCString(),
+            "fusedEntry"
+            );
+          DGBinding fusedBinding( fusedOperator, memberCount, layout );
+          if ( HasErrors( fusedOperator.getErrors() ) || HasErrors( fusedBinding.getErrors() ) )
+            ok = false;
+          else
+          {
+            for ( uint32_t i=0; i<count; ++i )
+              bindingList.remove( start );
+            bindingList.insert( fusedBinding, start );
+            m_operators = (DGOperator **)realloc( m_operators, ( m_operatorCount + 1 ) * sizeof(DGOperator *) );
+            m_operators[m_operatorCount++] = new DGOperator( fusedOperator );
+          }
+        }
+        catch ( Exception const & )
+        {
+          ok = false;
+        }
+        if ( !ok && fusedOperator.isValid() )
+          fusedOperator.destroy();
+
+        delete [] layoutStrings;
+        free( layout );
+      }
+
+      free( declared );
+      free( memberList );
+      free( operatorNames );
+      return ok;
+    }
+
+    void save( DGNode &node, DGBindingList &bindingList )
+    {
+      char const *nodeName = node.getName();
+      for ( uint32_t i=0; i<m_savedCount; ++i )
+      {
+        if ( strcmp( m_saved[i]->node.getName(), nodeName ) == 0 )
+          return;
+      }
+      Saved *saved = new Saved;
+      saved->node = node;
+      saved->count = bindingList.getCount();
+      saved->bindings = new DGBinding[saved->count];
+      for ( uint32_t i=0; i<saved->count; ++i )
+        saved->bindings[i] = bindingList.getBinding( i );
+      m_saved = (Saved **)realloc( m_saved, ( m_savedCount + 1 ) * sizeof(Saved *) );
+      m_saved[m_savedCount++] = saved;
+    }
+
+    void clear()
+    {
+      for ( uint32_t i=0; i<m_savedCount; ++i )
+      {
+        delete [] m_saved[i]->bindings;
+        delete m_saved[i];
+      }
+      free( m_saved );
+      m_saved = 0;
+      m_savedCount = 0;
+      for ( uint32_t i=0; i<m_operatorCount; ++i )
+        delete m_operators[i];
+      free( m_operators );
+      m_operators = 0;
+      m_operatorCount = 0;
+    }
+
+  public:
+
+    DGOperatorFuser( Client const &client )
+      : m_client( client )
+      , m_saved( 0 )
+      , m_savedCount( 0 )
+      , m_operators( 0 )
+      , m_operatorCount( 0 )
+      , m_fusedPassCount( 0 )
+      , m_nextId( 0 )
+    {
+    }
+
+    ~DGOperatorFuser()
+    {
+      clear();
+    }
+
+    /*!
+     * Fuses the eligible runs of the node's binding list and returns the
+     * number of binding passes removed.
+     */
+    uint32_t fuse( DGNode &node )
+    {
+      DGBindingList bindingList = node.getBindingList();
+      uint32_t removed = 0;
+      uint32_t index = 0;
+      while ( index < bindingList.getCount() )
+      {
+        uint32_t runLength = 0;
+        while ( index + runLength < bindingList.getCount() )
+        {
+          DGBinding binding = bindingList.getBinding( index + runLength );
+          Variant layout;
+          bool eligible = false;
+          try
+          {
+            eligible = GetSliceMembers( node, binding, layout );
+          }
+          catch ( Exception const & )
+          {
+          }
+          if ( !eligible )
+            break;
+          ++runLength;
+        }
+
+        if ( runLength >= 2 )
+        {
+          save( node, bindingList );
+          if ( fuseRun( node, bindingList, index, runLength ) )
+          {
+            removed += runLength - 1;
+            ++m_fusedPassCount;
+            index += 1;
+            continue;
+          }
+        }
+        index += runLength > 0 ? runLength : 1;
+      }
+      return removed;
     }
-    
-    void setMemberSliceArrayData(
-      char const *memberCString,
-      uint32_t index,
-      uint32_t bufferSize,
-      void const *buffer
-      )
+
+    /*!
+     * Puts back the original binding lists of every fused node.
+     */
+    void restore()
     {
-      ensureIsValid();
-      FEC_DGContainerSetMemberSliceArrayData(
-        getCRef(),
-        memberCString,
-        index,
-        bufferSize,
-        buffer
-        );
-      Exception::MaybeThrow();
+      for ( uint32_t i=0; i<m_savedCount; ++i )
+      {
+        Saved *saved = m_saved[i];
+        if ( saved->node.isValid() )
+        {
+          DGBindingList bindingList = saved->node.getBindingList();
+          while ( bindingList.getCount() > 0 )
+            bindingList.remove( 0 );
+          for ( uint32_t j=0; j<saved->count; ++j )
+            bindingList.append( saved->bindings[j] );
+        }
+      }
+      for ( uint32_t i=0; i<m_operatorCount; ++i )
+      {
+        if ( m_operators[i]->isValid() )
+          m_operators[i]->destroy();
+      }
+      clear();
     }
-    
-    void getMemberAllSlicesData(
-      char const *memberCString,
-      uint32_t bufferSize,
-      void *buffer
-      )
+
+    uint32_t getFusedPassCount() const
     {
-      ensureIsValid();
-      FEC_DGContainerGetMemberAllSlicesData(
-        getCRef(),
-        memberCString,
-        bufferSize,
-        buffer
-        );
-      Exception::MaybeThrow();
+      return m_fusedPassCount;
     }
-    
-    void setMemberAllSlicesData(
-      char const *memberCString,
-      uint32_t bufferSize,
-      void const *buffer
-      )
+  };
+
+  /*
+   * C++ - DG Event Traversal
+   */
+
+  /*!
+   * Fires a DGEvent with its independent handler subtrees running
+   * concurrently.
+   *
+   * The event's top-level handlers are split into contiguous groups, one
+   * per thread at most, and each group is appended to a companion event
+   * that is fired on a TaskPool.  Every subtree is still traversed by the
+   * runtime, so pre-descend bindings, children and post-descend bindings
+   * keep their order within it; only siblings run concurrently.  When the
+   * event has a single top-level handler without bindings or scopes, its
+   * children are split instead, so wrapper handlers don't hide the
+   * parallelism below them.
+   *
+   * Companion events are created once and reused until the handler list
+   * changes.  Before every concurrent fire the groups are checked to be
+   * disjoint: no handler, scoped node or node those depend on may be
+   * reached from two groups, and every scope has to resolve to a node.
+   * Otherwise the event is fired as a whole.
+   *
+   * By default every event is fired as a whole.  Firing the groups
+   * concurrently with setConcurrentFiring( true ) requires a runtime whose
+   * FEC_DGEventFire is reentrant across events and whose last exception
+   * is kept per thread; neither is documented by the C API.
+   */
+  class DGEventTraverser
+  {
+    struct Part
     {
-      ensureIsValid();
-      FEC_DGContainerSetMemberAllSlicesData(
-        getCRef(),
-        memberCString,
-        bufferSize,
-        buffer
-        );
-      Exception::MaybeThrow();
+      DGEventTraverser *traverser;
+      DGEvent event;
+    };
+
+    struct Plan
+    {
+      SmallString eventName;
+      SmallString signature;
+      Part *parts;
+      uint32_t partCount;
+
+      Plan()
+        : parts( 0 )
+        , partCount( 0 )
+      {
+      }
+    };
+
+    Client m_client;
+    TaskPool m_pool;
+    Plan **m_plans;
+    uint32_t m_planCount;
+    Mutex m_mutex;
+    bool m_failed;
+    SmallString m_error;
+    uint32_t m_lastPartCount;
+    uint32_t m_id;
+    bool m_concurrent;
+
+    // the containers one part can reach, see isDisjoint()
+    struct Reach
+    {
+      DGEventTraverser *traverser;
+      StringPool *claimed;
+      StringPool own;
+      bool disjoint;
+    };
+
+    DGEventTraverser( DGEventTraverser const & );
+    DGEventTraverser &operator =( DGEventTraverser const & );
+
+    // a process wide number per traverser, which keeps the companion
+    // events of traversers over the same event apart
+    static uint32_t NextId()
+    {
+      static Mutex mutex;
+      static uint32_t nextId = 0;
+      MutexLock lock( mutex );
+      return nextId++;
     }
-    
-    float getMemberSliceData_Float32(
-      char const *memberCString,
-      uint32_t index
-      )
+
+    static void AppendNames( Variant const &names, char const ***list, uint32_t *count )
     {
-      ensureIsValid();
-      float result = FEC_DGContainerGetMemberSliceData_Float32(
-        getCRef(),
-        memberCString,
-        index
-        );
-      Exception::MaybeThrow();
-      return result;
+      if ( names.isDict() )
+      {
+        for ( Variant::DictIter it( names ); !it.isDone(); it.next() )
+        {
+          *list = (char const **)realloc( *list, ( *count + 1 ) * sizeof(char const *) );
+          (*list)[(*count)++] = it.getKey()->getString_cstr();
+        }
+      }
+      else if ( names.isArray() )
+      {
+        for ( uint32_t i=0; i<names.getArraySize(); ++i )
+        {
+          Variant const *element = names.getArrayElement( i );
+          if ( !element->isString() )
+            continue;
+          *list = (char const **)realloc( *list, ( *count + 1 ) * sizeof(char const *) );
+          (*list)[(*count)++] = element->getString_cstr();
+        }
+      }
     }
-    
-    void setMemberSliceData_Float32(
-      char const *memberCString,
-      uint32_t index,
-      float value
-      )
+
+    static bool IsEmpty( Variant const &variant )
     {
-      ensureIsValid();
-      FEC_DGContainerSetMemberSliceData_Float32(
-        getCRef(),
-        memberCString,
-        index,
-        value
-        );
-      Exception::MaybeThrow();
+      if ( variant.isDict() )
+        return Variant::DictIter( variant ).isDone();
+      if ( variant.isArray() )
+        return variant.getArraySize() == 0;
+      return true;
     }
-    
-    Variant getMemberSliceData_Variant(
-      char const *memberCString,
-      uint32_t index
-      )
+
+    static void EventTask( void *userdata )
     {
-      ensureIsValid();
-      FEC_Variant result;
-      FEC_VariantInitWithDGContainerGetMemberSlice(
-        &result,
-        getCRef(),
-        memberCString,
-        index
-        );
-      Exception::MaybeThrow();
-      return Variant( &result );
+      Part *part = static_cast<Part *>( userdata );
+      try
+      {
+        part->event.fire();
+      }
+      catch ( Exception const &e )
+      {
+        part->traverser->fail( e.getDescData(), e.getDescLength() );
+      }
+      catch ( ... )
+      {
+        static char const message[] = "DGEventTraverser: unknown exception";
+        part->traverser->fail( message, sizeof(message) - 1 );
+      }
     }
-    
-    void setMemberSliceData_Variant(
-      char const *memberCString,
-      uint32_t index,
-      Variant &variant
-      )
+
+    void fail( char const *data, uint32_t length )
     {
-      ensureIsValid();
-      FEC_DGContainerSetMemberSlice_Variant(
-        getCRef(),
-        memberCString,
-        index,
-        variant.getData()
-        );
-      Exception::MaybeThrow();
+      MutexLock lock( m_mutex );
+      if ( !m_failed )
+      {
+        m_failed = true;
+        m_error.assign( data, length );
+      }
     }
-    
-    void setSliceData_Variant(
-      uint32_t index,
-      Variant &variant
+
+    // returns true if the name was first reached by this part
+    static bool Claim( Reach &reach, char const *name )
+    {
+      if ( reach.own.find( name ) )
+        return false;
+      if ( reach.claimed->find( name ) )
+      {
+        reach.disjoint = false;
+        return false;
+      }
+      reach.own.intern( name );
+      reach.claimed->intern( name );
+      return true;
+    }
+
+    static void ClaimNode( Reach &reach, DGNode &node )
+    {
+      if ( !node.isValid() )
+      {
+        reach.disjoint = false;
+        return;
+      }
+      if ( !Claim( reach, node.getName() ) )
+        return;
+      char const **names = 0;
+      uint32_t count = 0;
+      AppendNames( node.getDependencies_Variant(), &names, &count );
+      for ( uint32_t i=0; i<count && reach.disjoint; ++i )
+      {
+        DGNode dependency = node.getDependency( names[i] );
+        ClaimNode( reach, dependency );
+      }
+      free( names );
+    }
+
+    static void ClaimHandlers( Reach &reach, Variant const &handlers )
+    {
+      char const **names = 0;
+      uint32_t count = 0;
+      AppendNames( handlers, &names, &count );
+      for ( uint32_t i=0; i<count && reach.disjoint; ++i )
+      {
+        if ( !Claim( reach, names[i] ) )
+          continue;
+        DGEventHandler handler = DGEventHandler::GetByName( reach.traverser->m_client, names[i] );
+        if ( !handler.isValid() )
+        {
+          reach.disjoint = false;
+          break;
+        }
+        Variant scopes = handler.getScopes_Variant();
+        if ( scopes.isDict() )
+        {
+          for ( Variant::DictIter it( scopes ); !it.isDone() && reach.disjoint; it.next() )
+          {
+            if ( !it.getValue()->isString() )
+            {
+              reach.disjoint = false;
+              break;
+            }
+            DGNode node = DGNode::GetByName( reach.traverser->m_client, it.getValue()->getString_cstr() );
+            ClaimNode( reach, node );
+          }
+        }
+        else if ( !IsEmpty( scopes ) )
+          reach.disjoint = false;
+        if ( reach.disjoint )
+          ClaimHandlers( reach, handler.getChildEventHandlers_Variant() );
+      }
+      free( names );
+    }
+
+    // whether no container can be reached from two parts of the plan.
+    // scopes can change without the handler list changing, so this is
+    // checked before every concurrent fire rather than cached
+    bool isDisjoint( Plan &plan )
+    {
+      StringPool claimed;
+      try
+      {
+        for ( uint32_t i=0; i<plan.partCount; ++i )
+        {
+          Reach reach;
+          reach.traverser = this;
+          reach.claimed = &claimed;
+          reach.disjoint = true;
+          ClaimHandlers( reach, plan.parts[i].event.getEventHandlers_Variant() );
+          if ( !reach.disjoint )
+            return false;
+        }
+      }
+      catch ( Exception const & )
+      {
+        return false;
+      }
+      return true;
+    }
+
+    static void DestroyPlan( Plan &plan )
+    {
+      for ( uint32_t i=0; i<plan.partCount; ++i )
+      {
+        if ( plan.parts[i].event.isValid() )
+          plan.parts[i].event.destroy();
+      }
+      delete [] plan.parts;
+      plan.parts = 0;
+      plan.partCount = 0;
+    }
+
+    Plan &getPlan( DGEvent &event )
+    {
+      // the handlers to split: the top level, or the children of a single
+      // top-level handler that neither binds operators nor sets scopes
+      Variant topLevel = event.getEventHandlers_Variant();
+      Variant children;
+      char const **names = 0;
+      uint32_t count = 0;
+      AppendNames( topLevel, &names, &count );
+      if ( count == 1 )
+      {
+        DGEventHandler root = DGEventHandler::GetByName( m_client, names[0] );
+        if ( root.getPreDescendBindingList().getCount() == 0
+          && root.getPostDescendBindingList().getCount() == 0
+          && IsEmpty( root.getScopes_Variant() ) )
+        {
+          children = root.getChildEventHandlers_Variant();
+          count = 0;
+          AppendNames( children, &names, &count );
+        }
+      }
+
+      char const *eventName = event.getName();
+      uint32_t eventNameLength = uint32_t( strlen( eventName ) );
+      uint64_t signatureLength = 0;
+      for ( uint32_t i=0; i<count; ++i )
+        signatureLength += strlen( names[i] ) + 1;
+      char *signature = (char *)malloc( size_t( signatureLength + 1 ) );
+      char *cursor = signature;
+      for ( uint32_t i=0; i<count; ++i )
+      {
+        size_t length = strlen( names[i] );
+        memcpy( cursor, names[i], length );
+        cursor[length] = '\n';
+        cursor += length + 1;
+      }
+      *cursor = '\0';
+
+      Plan *plan = 0;
+      for ( uint32_t i=0; i<m_planCount && !plan; ++i )
+      {
+        if ( m_plans[i]->eventName.equals( eventName, eventNameLength ) )
+          plan = m_plans[i];
+      }
+      if ( !plan )
+      {
+        plan = new Plan;
+        m_plans = (Plan **)realloc( m_plans, ( m_planCount + 1 ) * sizeof(Plan *) );
+        m_plans[m_planCount++] = plan;
+        plan->eventName.assign( eventName, eventNameLength );
+      }
+      else if ( plan->signature.equals( signature, uint32_t( signatureLength ) ) )
+      {
+        free( signature );
+        free( names );
+        return *plan;
+      }
+
+      DestroyPlan( *plan );
+      plan->signature.assign( signature, uint32_t( signatureLength ) );
+      uint32_t partCount = count < m_pool.getThreadCount() ? count : m_pool.getThreadCount();
+      if ( partCount > 1 )
+      {
+        plan->parts = new Part[partCount];
+        plan->partCount = partCount;
+        for ( uint32_t i=0; i<partCount; ++i )
+        {
+          char partName[48];
+          sprintf( partName, "__traverser%u_part%u", unsigned( m_id ), unsigned( i ) );
+          char *name = (char *)malloc( eventNameLength + strlen( partName ) + 1 );
+          memcpy( name, eventName, eventNameLength );
+          strcpy( name + eventNameLength, partName );
+          Part &part = plan->parts[i];
+          part.traverser = this;
+          part.event = DGEvent( m_client, name );
+          free( name );
+          uint32_t begin = uint32_t( uint64_t( count ) * i / partCount );
+          uint32_t end = uint32_t( uint64_t( count ) * ( i + 1 ) / partCount );
+          for ( uint32_t j=begin; j<end; ++j )
+            part.event.appendEventHandler( DGEventHandler::GetByName( m_client, names[j] ) );
+        }
+      }
+      free( signature );
+      free( names );
+      return *plan;
+    }
+
+  public:
+
+    DGEventTraverser(
+      Client const &client,
+      uint32_t threadCount = 0xffffffffu
       )
+      : m_client( client )
+      , m_pool( threadCount )
+      , m_plans( 0 )
+      , m_planCount( 0 )
+      , m_failed( false )
+      , m_lastPartCount( 0 )
+      , m_id( NextId() )
+      , m_concurrent( false )
     {
-      ensureIsValid();
-      FEC_DGContainerSetSlice_Variant(
-        getCRef(),
-        index,
-        variant.getData()
-        );
-      Exception::MaybeThrow();
     }
-    
-    Variant getBulkData_Variant()
+
+    ~DGEventTraverser()
+    {
+      for ( uint32_t i=0; i<m_planCount; ++i )
+      {
+        DestroyPlan( *m_plans[i] );
+        delete m_plans[i];
+      }
+      free( m_plans );
+    }
+
+    /*!
+     * Lets disjoint handler subtrees be fired concurrently instead of
+     * firing every event as a whole.  Only enable this for a runtime known
+     * to support it, see above.
+     */
+    void setConcurrentFiring( bool concurrent )
+    {
+      m_concurrent = concurrent;
+    }
+
+    bool getConcurrentFiring() const
+    {
+      return m_concurrent;
+    }
+
+    /*!
+     * Fires the event, running independent handler subtrees concurrently
+     * if enabled.  Events that cannot be split are fired as usual.
+     */
+    void fire( DGEvent &event )
+    {
+      m_lastPartCount = 0;
+      if ( !m_concurrent )
+      {
+        event.fire();
+        return;
+      }
+      Plan &plan = getPlan( event );
+      if ( plan.partCount < 2 || !isDisjoint( plan ) )
+      {
+        event.fire();
+        return;
+      }
+      m_lastPartCount = plan.partCount;
+      m_failed = false;
+      for ( uint32_t i=0; i<plan.partCount; ++i )
+        m_pool.submit( &EventTask, &plan.parts[i] );
+      m_pool.wait();
+      if ( m_failed )
+        Exception::Throw( m_error.getCString() );
+    }
+
+    // the number of concurrently fired parts of the last fire(), 0 when
+    // the event was fired as a whole
+    uint32_t getLastPartCount() const
+    {
+      return m_lastPartCount;
+    }
+  };
+
+  /*
+   * C++ - DG Select Caching
+   */
+
+  /*!
+   * Memoizes DGEvent::select_Variant() per event.
+   *
+   * A cached selection stays valid while none of the containers it can
+   * read has been written according to DGWriteVersions: the event, its
+   * handlers and the nodes they scope.  If a scope can't be resolved to a
+   * node, the selection isn't cached and every select() recomputes it.
+   *
+   * DGContainer setters are seen by every cache, but evaluations and
+   * fires write through the runtime: make them with evaluate() and fire()
+   * of a cache, which bump the containers they may write, or call
+   * invalidate() after them.
+   *
+   * selectInto() returns the selection as a packed typed buffer: the
+   * numeric leaves of each selected value, in order, converted to T.
+   */
+  class DGSelectCache
+  {
+    struct Entry
+    {
+      DGEvent event;
+      uint64_t generation;
+      bool tracked;
+      SmallString *containers;
+      uint64_t *versions;
+      uint32_t containerCount;
+      Variant result;
+      double *values;
+      uint32_t valueCount;
+      uint32_t elementCount;
+      uint32_t stride;
+
+      Entry()
+        : generation( 0 )
+        , tracked( false )
+        , containers( 0 )
+        , versions( 0 )
+        , containerCount( 0 )
+        , values( 0 )
+        , valueCount( 0 )
+        , elementCount( 0 )
+        , stride( 0 )
+      {
+      }
+
+      ~Entry()
+      {
+        clear();
+      }
+
+      void clear()
+      {
+        delete [] containers;
+        containers = 0;
+        free( versions );
+        versions = 0;
+        containerCount = 0;
+        free( values );
+        values = 0;
+        valueCount = 0;
+        elementCount = 0;
+        stride = 0;
+      }
+    };
+
+    Client m_client;
+    Entry **m_entries;
+    uint32_t m_entryCount;
+    uint64_t m_hitCount;
+    uint64_t m_missCount;
+
+    DGSelectCache( DGSelectCache const & );
+    DGSelectCache &operator =( DGSelectCache const & );
+
+    static void ForEachName( Variant const &names, void (*func)( void *, char const * ), void *userdata )
     {
-      ensureIsValid();
-      FEC_Variant result;
-      FEC_VariantInitWithDGContainerGetBulkData( &result, getCRef() );
-      Exception::MaybeThrow();
-      return Variant( &result );
+      if ( names.isDict() )
+      {
+        for ( Variant::DictIter it( names ); !it.isDone(); it.next() )
+          func( userdata, it.getKey()->getString_cstr() );
+      }
+      else if ( names.isArray() )
+      {
+        for ( uint32_t i=0; i<names.getArraySize(); ++i )
+        {
+          if ( names.getArrayElement( i )->isString() )
+            func( userdata, names.getArrayElement( i )->getString_cstr() );
+        }
+      }
     }
-    
-    void setBulkData_Variant( Variant &variant )
+
+    struct Gather
     {
-      ensureIsValid();
-      FEC_DGContainerSetBulkData_Variant( getCRef(), variant.getData() );
-      Exception::MaybeThrow();
+      DGSelectCache *cache;
+      StringPool handlers;
+      StringPool nodes;
+      SmallString *containers;
+      uint32_t count;
+      uint32_t capacity;
+      bool tracked;
+
+      Gather( DGSelectCache *cache_ )
+        : cache( cache_ )
+        , containers( 0 )
+        , count( 0 )
+        , capacity( 0 )
+        , tracked( true )
+      {
+      }
+
+      ~Gather()
+      {
+        delete [] containers;
+      }
+    };
+
+    static void AddContainer( Gather &gather, DGContainer const &container )
+    {
+      if ( gather.count == gather.capacity )
+      {
+        uint32_t capacity = gather.capacity ? gather.capacity * 2 : 16;
+        SmallString *containers = new SmallString[capacity];
+        for ( uint32_t i=0; i<gather.count; ++i )
+          containers[i] = gather.containers[i];
+        delete [] gather.containers;
+        gather.containers = containers;
+        gather.capacity = capacity;
+      }
+      gather.containers[gather.count++] = SmallString( container.getName() );
     }
-  };
-  
-  class DGNode : public DGContainer
-  {
-  protected:
-    
-    DGNode( FEC_DGNodeRef that )
-      : DGContainer( that )
+
+    static void GatherHandler( void *userdata, char const *name )
     {
+      Gather &gather = *static_cast<Gather *>( userdata );
+      if ( gather.handlers.find( name ) )
+        return;
+      gather.handlers.intern( name );
+      DGEventHandler handler = DGEventHandler::GetByName( gather.cache->m_client, name );
+      AddContainer( gather, handler );
+
+      Variant scopes = handler.getScopes_Variant();
+      if ( scopes.isDict() )
+      {
+        for ( Variant::DictIter it( scopes ); !it.isDone(); it.next() )
+        {
+          Variant const *value = it.getValue();
+          if ( !value->isString() )
+          {
+            gather.tracked = false;
+            continue;
+          }
+          if ( gather.nodes.find( value->getString_cstr() ) )
+            continue;
+          gather.nodes.intern( value->getString_cstr() );
+          DGNode node = DGNode::GetByName( gather.cache->m_client, value->getString_cstr() );
+          if ( node.isValid() )
+            AddContainer( gather, node );
+          else
+            gather.tracked = false;
+        }
+      }
+      else if ( !IsEmpty( scopes ) )
+        gather.tracked = false;
+
+      ForEachName( handler.getChildEventHandlers_Variant(), &GatherHandler, userdata );
     }
-    
-  public:
-    
-    DGNode()
+
+    static bool IsEmpty( Variant const &variant )
     {
+      if ( variant.isDict() )
+        return Variant::DictIter( variant ).isDone();
+      if ( variant.isArray() )
+        return variant.getArraySize() == 0;
+      return true;
     }
-    
-    DGNode(
-      Client const &client,
-      char const *nameCString
-      )
-      : DGContainer( FEC_DGNodeCreate(
-        client.getCRef(),
-        nameCString
-        ) )
+
+    static void Flatten( Variant const &value, double **values, uint32_t *count, uint32_t *capacity )
     {
+      double number = 0.0;
+      if ( value.isArray() )
+      {
+        for ( uint32_t i=0; i<value.getArraySize(); ++i )
+          Flatten( *value.getArrayElement( i ), values, count, capacity );
+        return;
+      }
+      if ( value.isDict() )
+      {
+        for ( Variant::DictIter it( value ); !it.isDone(); it.next() )
+          Flatten( *it.getValue(), values, count, capacity );
+        return;
+      }
+      if ( value.isFloat32() ) number = value.getFloat32();
+      else if ( value.isFloat64() ) number = value.getFloat64();
+      else if ( value.isSInt32() ) number = value.getSInt32();
+      else if ( value.isUInt32() ) number = value.getUInt32();
+      else if ( value.isSInt64() ) number = double( value.getSInt64() );
+      else if ( value.isUInt64() ) number = double( value.getUInt64() );
+      else if ( value.isSInt16() ) number = value.getSInt16();
+      else if ( value.isUInt16() ) number = value.getUInt16();
+      else if ( value.isSInt8() ) number = value.getSInt8();
+      else if ( value.isUInt8() ) number = value.getUInt8();
+      else if ( value.isBoolean() ) number = value.getBoolean() ? 1.0 : 0.0;
+      else
+        return;
+      if ( *count == *capacity )
+      {
+        uint32_t grown = *capacity ? *capacity * 2 : 64;
+        double *resized = (double *)realloc( *values, grown * sizeof(double) );
+        if ( !resized )
+          Exception::Throw( "DGSelectCache: out of memory" );
+        *values = resized;
+        *capacity = grown;
+      }
+      (*values)[(*count)++] = number;
     }
-    
-    DGNode( DGNode const &that )
-      : DGContainer( that )
+
+    bool isCurrent( Entry const &entry ) const
     {
+      if ( !entry.tracked || entry.generation != DGWriteVersions::GetGeneration() )
+        return false;
+      for ( uint32_t i=0; i<entry.containerCount; ++i )
+      {
+        if ( entry.versions[i] != DGWriteVersions::Get( entry.containers[i].getCString() ) )
+          return false;
+      }
+      return true;
+    }
+
+    // recomputes the selection, leaving the entry untouched if that throws
+    void refresh( Entry &entry )
+    {
+      uint64_t generation = DGWriteVersions::GetGeneration();
+      Gather gather( this );
+      AddContainer( gather, entry.event );
+      ForEachName( entry.event.getEventHandlers_Variant(), &GatherHandler, &gather );
+      uint64_t *versions = (uint64_t *)malloc( ( gather.count + 1 ) * sizeof(uint64_t) );
+      if ( !versions )
+        Exception::Throw( "DGSelectCache: out of memory" );
+      for ( uint32_t i=0; i<gather.count; ++i )
+        versions[i] = DGWriteVersions::Get( gather.containers[i].getCString() );
+      Variant result;
+      try
+      {
+        result = entry.event.select_Variant();
+      }
+      catch ( ... )
+      {
+        free( versions );
+        throw;
+      }
+
+      entry.clear();
+      entry.generation = generation;
+      entry.tracked = gather.tracked;
+      entry.containers = gather.containers;
+      entry.containerCount = gather.count;
+      gather.containers = 0;
+      entry.versions = versions;
+      entry.result = result;
     }
-    
-    DGNode &operator =( DGNode const &that )
+
+    Entry &lookup( DGEvent &event )
     {
-      set( that );
-      return *this;
+      for ( uint32_t i=0; i<m_entryCount; ++i )
+      {
+        if ( m_entries[i]->event.getCRef() == event.getCRef() )
+        {
+          if ( isCurrent( *m_entries[i] ) )
+          {
+            ++m_hitCount;
+            return *m_entries[i];
+          }
+          ++m_missCount;
+          refresh( *m_entries[i] );
+          return *m_entries[i];
+        }
+      }
+      Entry *entry = new Entry;
+      entry->event = event;
+      m_entries = (Entry **)realloc( m_entries, ( m_entryCount + 1 ) * sizeof(Entry *) );
+      m_entries[m_entryCount++] = entry;
+      ++m_missCount;
+      refresh( *entry );
+      return *entry;
     }
-    
-    void evaluate()
+
+  public:
+
+    DGSelectCache( Client const &client )
+      : m_client( client )
+      , m_entries( 0 )
+      , m_entryCount( 0 )
+      , m_hitCount( 0 )
+      , m_missCount( 0 )
     {
-      ensureIsValid();
-      FEC_DGNodeEvaluate( getCRef() );
-      Exception::MaybeThrow();
+      DGWriteVersions::AttachCache();
     }
-    
-    void setDependency(
-      char const *nameCString,
-      DGNode const &otherDGNode
-      )
+
+    ~DGSelectCache()
     {
-      ensureIsValid();
-      FEC_DGNodeSetDependency(
-        getCRef(),
-        nameCString,
-        otherDGNode.getCRef()
-        );
-      Exception::MaybeThrow();
+      invalidate();
+      DGWriteVersions::DetachCache();
     }
 
-    void removeDependency(
-      char const *nameCString
-      )
+    // evaluates the node, bumping it and the nodes it depends on
+    void evaluate( DGNode &node )
     {
-      ensureIsValid();
-      FEC_DGNodeRemoveDependency(
-        getCRef(),
-        nameCString
-        );
-      Exception::MaybeThrow();
+      try
+      {
+        node.evaluate();
+      }
+      catch ( ... )
+      {
+        DGWriteReach::Node( node, m_client );
+        throw;
+      }
+      DGWriteReach::Node( node, m_client );
     }
 
-    void appendBinding( DGBinding const &dgBinding )
+    // fires the event, bumping it, its handler trees and the nodes they scope
+    void fire( DGEvent &event )
     {
-      ensureIsValid();
-      FEC_DGNodeAppendBinding(
-        getCRef(),
-        dgBinding.getCRef()
-        );
-      Exception::MaybeThrow();
+      try
+      {
+        event.fire();
+      }
+      catch ( ... )
+      {
+        DGWriteReach::Event( event, m_client );
+        throw;
+      }
+      DGWriteReach::Event( event, m_client );
+    }
 
+    Variant const &select( DGEvent &event )
+    {
+      return lookup( event ).result;
     }
 
-    DGBindingList getBindingList()
+    /*!
+     * Copies the selection into buffer as elementCount * stride values
+     * and returns the element count.  At most capacity values are written;
+     * call with a null buffer to query the sizes.  Throws if the selected
+     * values don't all have the same number of numeric leaves.
+     */
+    template<typename T>
+    uint32_t selectInto( DGEvent &event, T *buffer, uint32_t capacity, uint32_t *stride = 0 )
     {
-      ensureIsValid();
-      FEC_DGBindingListRef result = FEC_DGNodeGetBindingList(
-        getCRef()
-        );
-      Exception::MaybeThrow();
-      return DGBindingList( result );
+      Entry &entry = lookup( event );
+      if ( !entry.values && entry.result.isArray() )
+      {
+        double *values = 0;
+        uint32_t valueCount = 0;
+        uint32_t valueCapacity = 0;
+        uint32_t valueStride = 0;
+        try
+        {
+          for ( uint32_t i=0; i<entry.result.getArraySize(); ++i )
+          {
+            Variant const *element = entry.result.getArrayElement( i );
+            Variant const *value = element->isDict() ? element->getDictValue( "value" ) : 0;
+            uint32_t before = valueCount;
+            Flatten( value ? *value : *element, &values, &valueCount, &valueCapacity );
+            uint32_t leaves = valueCount - before;
+            if ( i == 0 )
+              valueStride = leaves;
+            else if ( leaves != valueStride )
+              Exception::Throw( "DGSelectCache: selected values differ in layout" );
+          }
+        }
+        catch ( ... )
+        {
+          free( values );
+          throw;
+        }
+        entry.values = values;
+        entry.valueCount = valueCount;
+        entry.stride = valueStride;
+        entry.elementCount = entry.result.getArraySize();
+      }
+      if ( stride )
+        *stride = entry.stride;
+      uint32_t count = entry.valueCount < capacity ? entry.valueCount : capacity;
+      for ( uint32_t i=0; buffer && i<count; ++i )
+        buffer[i] = T( entry.values[i] );
+      return entry.elementCount;
     }
 
-    Variant getDependencies_Variant()
+    void invalidate()
     {
-      ensureIsValid();
-      FEC_Variant result = FEC_DGNodeGetDependencies_Variant(
-        getCRef()
-        );
-      Exception::MaybeThrow();
-      return Variant( &result );
+      for ( uint32_t i=0; i<m_entryCount; ++i )
+        delete m_entries[i];
+      free( m_entries );
+      m_entries = 0;
+      m_entryCount = 0;
     }
 
-    DGNode getDependency(
-      char const *nameCString
-      )
+    uint64_t getHitCount() const
     {
-      ensureIsValid();
-      FEC_DGNodeRef result = FEC_DGNodeGetDependency(
-        getCRef(),
-        nameCString
-        );
-      Exception::MaybeThrow();
-      return DGNode( result );
+      return m_hitCount;
     }
 
-    static DGNode GetByName(
-      Client const &client,
-      char const *nameCString
-      )
+    uint64_t getMissCount() const
     {
-      FEC_DGNamedObjectRef result = FEC_DGNamedObjectGetByName(
-        client.getCRef(),
-        nameCString,
-        "Node"
-        );
-      Exception::MaybeThrow();
-      return DGNode( result );
+      return m_missCount;
     }
   };
-  
-  class DGOperator : public DGContainer
+
+  /*
+   * C++ - DG Snapshots
+   */
+
+  /*!
+   * A snapshot of every member of a DGContainer in a memory-mappable file.
+   *
+   * Write() sizes the file up front, maps it and has the runtime copy
+   * shallow members straight into the mapping; variable arrays of shallow
+   * types are stored as per-slice counts followed by the packed elements,
+   * and anything else falls back to a JSON encoding.  Opening a snapshot
+   * maps the file read-only, so data is only paged in as restore() or
+   * getMemberData() touches it.
+   */
+  class DGSnapshot
   {
-    friend class DGBinding;
+  public:
 
-  protected:
-    
-    DGOperator( FEC_DGOperatorRef that )
-      : DGContainer( that )
+    enum MemberKind
     {
-    }
-    
-  public:
+      MemberKind_Shallow = 0,
+      MemberKind_Array = 1,
+      MemberKind_Encoded = 2
+    };
 
-    DGOperator()
+  private:
+
+    struct FileHeader
     {
-    }
-    
-    DGOperator(
-      Client const &client,
-      char const *nameCString,
-      char const *filenameCString,
-      char const *sourceCodeCString,
-      char const *entryPointCString
-      )
-      : DGContainer( FEC_DGOperatorCreate(
-        client.getCRef(),
-        nameCString,
-        filenameCString,
-        sourceCodeCString,
-        entryPointCString
-        ) )
+      char magic[8];
+      uint32_t version;
+      uint32_t sliceCount;
+      uint32_t memberCount;
+      uint32_t reserved;
+      uint64_t fileSize;
+    };
+
+    struct FileMember
     {
-    }
-    
-    DGOperator(
-      Client const &client,
-      char const *nameCString
-      )
-      : DGContainer( FEC_DGOperatorCreateEmpty(
-        client.getCRef(),
-        nameCString
-        ) )
+      uint64_t nameOffset;
+      uint64_t typeOffset;
+      uint64_t dataOffset;
+      uint64_t dataSize;
+      uint32_t kind;
+      uint32_t elementSize;
+    };
+
+    struct Plan
+    {
+      char const *name;
+      char const *type;
+      uint32_t kind;
+      uint32_t elementSize;
+      uint32_t *counts;
+      Variant encoded;
+      FileMember file;
+
+      Plan()
+        : counts( 0 )
+      {
+      }
+
+      ~Plan()
+      {
+        free( counts );
+      }
+    };
+
+    // owns the plans of Write(), however it is left
+    struct Plans
+    {
+      Plan *plans;
+
+      Plans( uint32_t count )
+        : plans( new Plan[count] )
+      {
+      }
+
+      ~Plans()
+      {
+        delete [] plans;
+      }
+    };
+
+    char const *m_data;
+    uint64_t m_size;
+
+    DGSnapshot( DGSnapshot const & );
+    DGSnapshot &operator =( DGSnapshot const & );
+
+    static uint64_t Align( uint64_t offset )
     {
+      return ( offset + 63 ) & ~uint64_t( 63 );
     }
-    
-    DGOperator( DGOperator const &that )
-      : DGContainer( that )
+
+    FileHeader const *header() const
     {
+      return reinterpret_cast<FileHeader const *>( m_data );
     }
-    
-    DGOperator &operator =( DGOperator const &that )
+
+    FileMember const *member( uint32_t index ) const
     {
-      set( that );
-      return *this;
+      return reinterpret_cast<FileMember const *>( m_data + sizeof(FileHeader) ) + index;
     }
-    
-    void setFilename(
-      char const *filenameCString
-      )
+
+    // true if a NUL terminated string starts at offset within the file
+    bool isString( uint64_t offset ) const
     {
-      ensureIsValid();
-      FEC_DGOperatorSetFilename(
-        getCRef(),
-        filenameCString
-        );
-      Exception::MaybeThrow();
+      return offset < m_size && memchr( m_data + offset, '\0', size_t( m_size - offset ) ) != 0;
     }
 
-    char const *getFilename()
+    /*!
+     * Checks every member entry against the mapped size, so that accessors
+     * and restore() never read outside the mapping, and that every size
+     * fits the 32-bit sizes of the DGContainer calls.
+     */
+    bool isValid() const
     {
-      ensureIsValid();
-      char const *str = FEC_DGOperatorGetFilename_cstr(
-        getCRef()
-        );
-      Exception::MaybeThrow();
-      return str;
+      FileHeader const *fileHeader = header();
+      if ( memcmp( fileHeader->magic, "FECSNAP", 8 ) != 0
+        || fileHeader->version != 1
+        || fileHeader->fileSize != m_size
+        || sizeof(FileHeader) + uint64_t( fileHeader->memberCount ) * sizeof(FileMember) > m_size )
+        return false;
+      uint32_t sliceCount = fileHeader->sliceCount;
+      for ( uint32_t i=0; i<fileHeader->memberCount; ++i )
+      {
+        FileMember const *entry = member( i );
+        if ( !isString( entry->nameOffset )
+          || !isString( entry->typeOffset )
+          || entry->dataOffset > m_size
+          || entry->dataSize > m_size - entry->dataOffset
+          || entry->dataSize > 0xffffffffu )
+          return false;
+        switch ( entry->kind )
+        {
+          case MemberKind_Shallow:
+            if ( entry->dataSize != uint64_t( entry->elementSize ) * sliceCount )
+              return false;
+            break;
+          case MemberKind_Array:
+          {
+            uint64_t countsSize = Align( uint64_t( sliceCount ) * sizeof(uint32_t) );
+            if ( entry->elementSize == 0 || entry->dataSize < countsSize )
+              return false;
+            uint32_t const *counts = reinterpret_cast<uint32_t const *>( m_data + entry->dataOffset );
+            uint64_t elementsSize = 0;
+            for ( uint32_t j=0; j<sliceCount; ++j )
+              elementsSize += uint64_t( counts[j] ) * entry->elementSize;
+            if ( elementsSize != entry->dataSize - countsSize )
+              return false;
+            break;
+          }
+          case MemberKind_Encoded:
+            break;
+          default:
+            return false;
+        }
+      }
+      return true;
     }
 
-    void setSourceCode(
-      char const *sourceCodeCString
-      )
+  public:
+
+    DGSnapshot()
+      : m_data( 0 )
+      , m_size( 0 )
     {
-      ensureIsValid();
-      FEC_DGOperatorSetSourceCode(
-        getCRef(),
-        sourceCodeCString
-        );
-      Exception::MaybeThrow();
     }
 
-    char const *getSourceCode()
+    ~DGSnapshot()
     {
-      ensureIsValid();
-      char const *str = FEC_DGOperatorGetSourceCode_cstr(
-        getCRef()
-        );
-      Exception::MaybeThrow();
-      return str;
+      close();
     }
 
-    void setEntryPoint(
-      char const *entryPointCString
+    /*!
+     * Writes all members of the container to the file at path.  The file
+     * is written next to path, flushed to disk and only then renamed over
+     * it, so an interrupted checkpoint never leaves a truncated snapshot
+     * behind.  Members of 4GB or more can't be passed through the
+     * DGContainer calls and are rejected.
+     */
+    static void Write(
+      Client const &client,
+      DGContainer &container,
+      char const *path
       )
     {
-      ensureIsValid();
-      FEC_DGOperatorSetEntryPoint(
-        getCRef(),
-        entryPointCString
-        );
-      Exception::MaybeThrow();
+      RTTypeCache types( client );
+      Write( types, container, path );
     }
 
-    const char *getEntryPoint()
+    /*!
+     * Same as above, resolving the element types of array members through
+     * types, which can be kept across checkpoints.
+     */
+    static void Write(
+      RTTypeCache &types,
+      DGContainer &container,
+      char const *path
+      )
     {
-      ensureIsValid();
-      char const *str = FEC_DGOperatorGetEntryPoint_cstr(
-        getCRef()
-        );
-      Exception::MaybeThrow();
-      return str;
+#if !defined(_WIN32)
+      uint32_t sliceCount = container.getSize();
+      Variant members = container.getMembers_Variant();
+      uint32_t memberCount = 0;
+      for ( Variant::DictIter it( members ); !it.isDone(); it.next() )
+        ++memberCount;
+
+      StringPool strings;
+      Plans ownedPlans( memberCount );
+      Plan *plans = ownedPlans.plans;
+      uint64_t stringsSize = 0;
+      uint32_t index = 0;
+      for ( Variant::DictIter it( members ); !it.isDone(); it.next(), ++index )
+      {
+        Plan &plan = plans[index];
+        plan.name = strings.intern( it.getKey()->getString_cstr() );
+        plan.type = strings.intern( container.getMemberType( plan.name ) );
+        plan.elementSize = 0;
+        stringsSize += strlen( plan.name ) + strlen( plan.type ) + 2;
+
+        uint32_t typeLength = uint32_t( strlen( plan.type ) );
+        if ( container.getMemberIsShallow( plan.name ) )
+        {
+          plan.kind = MemberKind_Shallow;
+          plan.elementSize = container.getMemberSize( plan.name );
+          plan.file.dataSize = uint64_t( plan.elementSize ) * sliceCount;
+        }
+        else if ( typeLength > 2 && strcmp( plan.type + typeLength - 2, "[]" ) == 0 )
+        {
+          SmallString elementType;
+          elementType.assign( plan.type, typeLength - 2 );
+          RTTypeCache::TypeID elementTypeID = types.getTypeID( elementType.getCString() );
+          if ( elementTypeID != RTTypeCache::InvalidTypeID && types.isShallow( elementTypeID ) )
+          {
+            plan.kind = MemberKind_Array;
+            plan.elementSize = types.getSize( elementTypeID );
+            plan.counts = (uint32_t *)malloc( sliceCount * sizeof(uint32_t) + 1 );
+            if ( !plan.counts )
+              Exception::Throw( "DGSnapshot: out of memory" );
+            uint64_t elementCount = 0;
+            for ( uint32_t i=0; i<sliceCount; ++i )
+            {
+              plan.counts[i] = container.getMemberSliceArraySize( plan.name, i );
+              elementCount += plan.counts[i];
+            }
+            plan.file.dataSize = Align( uint64_t( sliceCount ) * sizeof(uint32_t) )
+              + elementCount * plan.elementSize;
+          }
+          else
+            plan.kind = MemberKind_Encoded;
+        }
+        else
+          plan.kind = MemberKind_Encoded;
+
+        if ( plan.kind == MemberKind_Encoded )
+        {
+          Variant slices = Variant::CreateArray();
+          for ( uint32_t i=0; i<sliceCount; ++i )
+            slices.arrayAppend( container.getMemberSliceData_Variant( plan.name, i ) );
+          plan.encoded = slices.getJSONEncoding();
+          plan.file.dataSize = plan.encoded.getStringLength();
+        }
+
+        if ( plan.file.dataSize > 0xffffffffu )
+          Exception::Throw( "DGSnapshot: members of 4GB or more are not supported" );
+      }
+
+      // header, member table, strings, then every member's data aligned
+      uint64_t offset = sizeof(FileHeader) + uint64_t( memberCount ) * sizeof(FileMember);
+      uint64_t stringOffset = offset;
+      offset = Align( offset + stringsSize );
+      for ( uint32_t i=0; i<memberCount; ++i )
+      {
+        plans[i].file.nameOffset = stringOffset;
+        stringOffset += strlen( plans[i].name ) + 1;
+        plans[i].file.typeOffset = stringOffset;
+        stringOffset += strlen( plans[i].type ) + 1;
+        plans[i].file.dataOffset = offset;
+        plans[i].file.kind = plans[i].kind;
+        plans[i].file.elementSize = plans[i].elementSize;
+        offset = Align( offset + plans[i].file.dataSize );
+      }
+      uint64_t fileSize = offset;
+
+      // a unique temporary file, so that concurrent writers of the same
+      // path don't truncate each other's file before the rename
+      SmallString tempPath;
+      int fd = -1;
+      {
+        uint32_t length = uint32_t( strlen( path ) );
+        char *buffer = (char *)malloc( length + sizeof(".XXXXXX") );
+        if ( !buffer )
+          Exception::Throw( "DGSnapshot: out of memory" );
+        memcpy( buffer, path, length );
+        memcpy( buffer + length, ".XXXXXX", sizeof(".XXXXXX") );
+        fd = mkstemp( buffer );
+        tempPath.assign( buffer, uint32_t( length + sizeof(".XXXXXX") - 1 ) );
+        free( buffer );
+      }
+
+      char *mapped = 0;
+      if ( fd >= 0 && fchmod( fd, 0644 ) == 0 && ftruncate( fd, off_t( fileSize ) ) == 0 )
+      {
+        void *result = mmap( 0, size_t( fileSize ), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+        if ( result != MAP_FAILED )
+          mapped = static_cast<char *>( result );
+      }
+      if ( !mapped )
+      {
+        if ( fd >= 0 )
+        {
+          ::close( fd );
+          unlink( tempPath.getCString() );
+        }
+        Exception::Throw( "DGSnapshot: unable to create the snapshot file" );
+      }
+
+      bool failed = false;
+      char const *failedMember = 0;
+      SmallString error;
+      try
+      {
+        FileHeader *fileHeader = reinterpret_cast<FileHeader *>( mapped );
+        memcpy( fileHeader->magic, "FECSNAP", 8 );
+        fileHeader->version = 1;
+        fileHeader->sliceCount = sliceCount;
+        fileHeader->memberCount = memberCount;
+        fileHeader->reserved = 0;
+        fileHeader->fileSize = fileSize;
+        FileMember *fileMembers = reinterpret_cast<FileMember *>( mapped + sizeof(FileHeader) );
+        for ( uint32_t i=0; i<memberCount; ++i )
+        {
+          Plan &plan = plans[i];
+          failedMember = plan.name;
+          fileMembers[i] = plan.file;
+          strcpy( mapped + plan.file.nameOffset, plan.name );
+          strcpy( mapped + plan.file.typeOffset, plan.type );
+          char *data = mapped + plan.file.dataOffset;
+          switch ( plan.kind )
+          {
+            case MemberKind_Shallow:
+              if ( plan.file.dataSize > 0 )
+                container.getMemberAllSlicesData( plan.name, uint32_t( plan.file.dataSize ), data );
+              break;
+            case MemberKind_Array:
+            {
+              memcpy( data, plan.counts, sliceCount * sizeof(uint32_t) );
+              data += Align( uint64_t( sliceCount ) * sizeof(uint32_t) );
+              for ( uint32_t j=0; j<sliceCount; ++j )
+              {
+                uint32_t bytes = plan.counts[j] * plan.elementSize;
+                if ( bytes > 0 )
+                  container.getMemberSliceArrayData( plan.name, j, bytes, data );
+                data += bytes;
+              }
+              break;
+            }
+            default:
+              memcpy( data, plan.encoded.getStringData(), size_t( plan.file.dataSize ) );
+              break;
+          }
+        }
+      }
+      catch ( Exception const &e )
+      {
+        failed = true;
+        error.assign( e.getDescData(), e.getDescLength() );
+      }
+
+      // the data has to be on disk before the rename makes it visible
+      if ( !failed && ( msync( mapped, size_t( fileSize ), MS_SYNC ) != 0 || fsync( fd ) != 0 ) )
+      {
+        failed = true;
+        failedMember = 0;
+      }
+      munmap( mapped, size_t( fileSize ) );
+      ::close( fd );
+      if ( failed && failedMember )
+      {
+        unlink( tempPath.getCString() );
+        static char const prefix[] = "DGSnapshot: unable to read member ";
+        size_t nameLength = strlen( failedMember );
+        size_t length = sizeof(prefix) - 1 + nameLength + 2 + error.getLength();
+        char *message = (char *)malloc( length );
+        if ( !message )
+          Exception::Throw( "DGSnapshot: unable to read a member" );
+        memcpy( message, prefix, sizeof(prefix) - 1 );
+        memcpy( message + sizeof(prefix) - 1, failedMember, nameLength );
+        memcpy( message + sizeof(prefix) - 1 + nameLength, ": ", 2 );
+        memcpy( message + sizeof(prefix) + 1 + nameLength, error.getCString(), error.getLength() );
+        SmallString text( message, uint32_t( length ) );
+        free( message );
+        Exception::Throw( text.getCString(), text.getLength() );
+      }
+      if ( failed || rename( tempPath.getCString(), path ) != 0 )
+      {
+        unlink( tempPath.getCString() );
+        Exception::Throw( "DGSnapshot: unable to write the snapshot file" );
+      }
+#else
+      (void)types;
+      (void)container;
+      (void)path;
+      Exception::Throw( "DGSnapshot: memory-mapped snapshots are not supported on this platform" );
+#endif
     }
 
-    void setMainThreadOnly(
-      bool mainThreadOnly
-      )
+    // maps the snapshot at path, replacing any snapshot opened before
+    void open( char const *path )
+    {
+      close();
+#if !defined(_WIN32)
+      int fd = ::open( path, O_RDONLY );
+      if ( fd < 0 )
+        Exception::Throw( "DGSnapshot: unable to open the snapshot file" );
+      struct stat info;
+      void *result = MAP_FAILED;
+      if ( fstat( fd, &info ) == 0 && uint64_t( info.st_size ) >= sizeof(FileHeader) )
+        result = mmap( 0, size_t( info.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+      ::close( fd );
+      if ( result == MAP_FAILED )
+        Exception::Throw( "DGSnapshot: unable to map the snapshot file" );
+      m_data = static_cast<char const *>( result );
+      m_size = uint64_t( info.st_size );
+      if ( !isValid() )
+      {
+        close();
+        Exception::Throw( "DGSnapshot: not a valid snapshot file" );
+      }
+#else
+      (void)path;
+      Exception::Throw( "DGSnapshot: memory-mapped snapshots are not supported on this platform" );
+#endif
+    }
+
+    void close()
     {
-      ensureIsValid();
-      FEC_DGOperatorSetMainThreadOnly(
-        getCRef(),
-        mainThreadOnly
-        );
-      Exception::MaybeThrow();
+#if !defined(_WIN32)
+      if ( m_data )
+        munmap( const_cast<char *>( m_data ), size_t( m_size ) );
+#endif
+      m_data = 0;
+      m_size = 0;
     }
-    
-    bool getMainThreadOnly()
+
+    bool isOpen() const
     {
-      ensureIsValid();
-      bool mainThreadOnly = FEC_DGOperatorGetMainThreadOnly( getCRef() );
-      Exception::MaybeThrow();
-      return mainThreadOnly;
+      return m_data != 0;
     }
-    
-    Variant getDiagnostics()
+
+    uint32_t getSliceCount() const
     {
-      ensureIsValid();
-      FEC_DGCompiledObjectPrepareForExecution( getCRef() );
-      Exception::MaybeThrow();
-      
-      FEC_Variant result;
-      FEC_VariantInitWithDGOperatorGetDiagnostics( &result, getCRef() );
-      Exception::MaybeThrow();
-      return Variant( &result );
+      return header()->sliceCount;
     }
-    
-    static DGOperator GetByName(
-      Client const &client,
-      char const *nameCString
-      )
+
+    uint32_t getMemberCount() const
     {
-      FEC_DGNamedObjectRef result = FEC_DGNamedObjectGetByName(
-        client.getCRef(),
-        nameCString,
-        "Operator"
-        );
-      Exception::MaybeThrow();
-      return DGOperator( result );
+      return header()->memberCount;
     }
-  };
-  
-  inline DGBinding::DGBinding(
-    DGOperator const &dgOperator,
-    uint32_t parameterCount,
-    char const **parameters
-    )
-    : DGCompiledObject( FEC_DGBindingCreate(
-      dgOperator.getCRef(),
-      parameterCount,
-      parameters
-      ) )
-  {
-  }
-  
-  inline void DGBinding::setOperator( DGOperator const &dgOperator )
-  {
-    FEC_DGBindingSetOperator(
-      getCRef(),
-      dgOperator.getCRef()
-      );
-    Exception::MaybeThrow();
-  }
-  
-  inline DGOperator DGBinding::getOperator()
-  {
-    FEC_DGOperatorRef result = FEC_DGBindingGetOperator(
-      getCRef()
-      );
-    Exception::MaybeThrow();
-    return DGOperator( result );
-  }
-  
-  class DGEventHandler : public DGContainer
-  {
-  protected:
-    
-    DGEventHandler( FEC_DGEventHandlerRef that )
-      : DGContainer( that )
+
+    char const *getMemberName( uint32_t index ) const
     {
+      return m_data + member( index )->nameOffset;
     }
-    
-  public:
-    
-    DGEventHandler()
+
+    char const *getMemberType( uint32_t index ) const
     {
+      return m_data + member( index )->typeOffset;
     }
-    
-    DGEventHandler(
-      Client const &client,
-      char const *nameCString
-      )
-      : DGContainer( FEC_DGEventHandlerCreate(
-        client.getCRef(),
-        nameCString
-        ) )
+
+    MemberKind getMemberKind( uint32_t index ) const
     {
+      return MemberKind( member( index )->kind );
     }
-    
-    DGEventHandler( DGEventHandler const &that )
-      : DGContainer( that )
+
+    uint32_t getMemberElementSize( uint32_t index ) const
     {
+      return member( index )->elementSize;
     }
-    
-    DGEventHandler &operator =( DGEventHandler const &that )
+
+    // the mapped data of a member, see MemberKind for its layout
+    void const *getMemberData( uint32_t index, uint64_t *size = 0 ) const
     {
-      set( that );
-      return *this;
+      if ( size )
+        *size = member( index )->dataSize;
+      return m_data + member( index )->dataOffset;
     }
 
-    void appendChildEventHandler( DGEventHandler const &dgChildEventHandler )
+    /*!
+     * Resizes the container to the snapshot's slice count and sets every
+     * member from the mapped data, adding members the container lacks.
+     * Throws before changing anything if a member the container has is of
+     * a different type than in the snapshot.
+     */
+    void restore( DGContainer &container ) const
     {
-      ensureIsValid();
-      FEC_DGEventHandlerAppendChildEventHandler(
-        getCRef(),
-        dgChildEventHandler.getCRef()
-        );
-      Exception::MaybeThrow();
+      if ( !m_data )
+        Exception::Throw( "DGSnapshot: no snapshot is open" );
+      uint32_t sliceCount = getSliceCount();
+      Variant members = container.getMembers_Variant();
+      for ( uint32_t i=0; i<getMemberCount(); ++i )
+      {
+        if ( members.getDictValue( getMemberName( i ) )
+          && strcmp( container.getMemberType( getMemberName( i ) ), getMemberType( i ) ) != 0 )
+          Exception::Throw( "DGSnapshot: a member's type differs from the snapshot" );
+      }
+      for ( uint32_t i=0; i<getMemberCount(); ++i )
+      {
+        if ( !members.getDictValue( getMemberName( i ) ) )
+          container.addMember( getMemberName( i ), getMemberType( i ) );
+      }
+      container.setSize( sliceCount );
+
+      for ( uint32_t i=0; i<getMemberCount(); ++i )
+      {
+        char const *name = getMemberName( i );
+        uint64_t dataSize = 0;
+        char const *data = static_cast<char const *>( getMemberData( i, &dataSize ) );
+        switch ( getMemberKind( i ) )
+        {
+          case MemberKind_Shallow:
+            if ( dataSize > 0 )
+              container.setMemberAllSlicesData( name, uint32_t( dataSize ), data );
+            break;
+          case MemberKind_Array:
+          {
+            uint32_t const *counts = reinterpret_cast<uint32_t const *>( data );
+            data += Align( uint64_t( sliceCount ) * sizeof(uint32_t) );
+            uint32_t elementSize = getMemberElementSize( i );
+            for ( uint32_t j=0; j<sliceCount; ++j )
+            {
+              uint32_t bytes = counts[j] * elementSize;
+              container.setMemberSliceArraySize( name, j, counts[j] );
+              if ( bytes > 0 )
+                container.setMemberSliceArrayData( name, j, bytes, data );
+              data += bytes;
+            }
+            break;
+          }
+          default:
+          {
+            Variant slices = Variant::CreateFromJSON( data, uint32_t( dataSize ) );
+            for ( uint32_t j=0; j<sliceCount && j<slices.getArraySize(); ++j )
+            {
+              Variant slice( *slices.getArrayElement( j ) );
+              container.setMemberSliceData_Variant( name, j, slice );
+            }
+            break;
+          }
+        }
+      }
     }
-     
-    void removeChildEventHandler( DGEventHandler const &dgChildEventHandler )
+  };
+
+  /*
+   * C++ - Extension Loading
+   */
+
+  /*!
+   * Loads extensions into a client when they are first needed instead of
+   * at client creation.  Extensions that would have been passed as the
+   * `exts` of the Client constructor are deferred, and prepare() loads
+   * those a KL source needs before it is compiled: the extensions it
+   * requires and, given an ExtensionIndex, the deferred extensions
+   * declaring a type it mentions and their own requirements.  Extensions
+   * that weren't deferred are left to the client.
+   *
+   * Without an ExtensionIndex only the `require` statements of the source
+   * itself are seen: a deferred extension that is needed indirectly or
+   * for one of its types is loaded only once a source requires it by
+   * name, or through load() or loadAll().
+   *
+   * Every load is timed; getTimings_Variant() reports the seconds spent
+   * per extension and what triggered the load.
+   */
+  class ExtensionLoader
+  {
+    struct Load
     {
-      ensureIsValid();
-      FEC_DGEventHandlerRemoveChildEventHandler(
-        getCRef(),
-        dgChildEventHandler.getCRef()
-        );
-      Exception::MaybeThrow();
+      char const *name;
+      char const *trigger;
+      double seconds;
+    };
+
+    Client m_client;
+    ExtensionIndex const *m_index;
+    StringPool m_strings;
+    StringPool m_deferred;
+    StringPool m_loaded;
+    char const **m_deferredNames;
+    uint32_t m_deferredCount;
+    uint32_t m_pendingCount;
+    Load *m_loads;
+    uint32_t m_loadCount;
+    Mutex m_mutex;
+
+    ExtensionLoader( ExtensionLoader const & );
+    ExtensionLoader &operator =( ExtensionLoader const & );
+
+    struct Prepare
+    {
+      ExtensionLoader *loader;
+      uint32_t count;
+      char const *trigger;
+    };
+
+    static void LoadRequired( void *userdata, char const *name, uint32_t length )
+    {
+      Prepare &prepare = *static_cast<Prepare *>( userdata );
+      if ( !prepare.loader->m_deferred.find( name, length ) )
+        return;
+      SmallString nameString( name, length );
+      if ( prepare.loader->loadLocked( nameString.getCString(), prepare.trigger ) )
+        ++prepare.count;
     }
-    
-    void appendPreDescendBinding( DGBinding const &dgBinding )
+
+    // the extensions being loaded further up the stack, which breaks
+    // cycles of requirements
+    struct Visit
     {
-      ensureIsValid();
-      FEC_DGEventHandlerAppendPreDescendBinding(
-        getCRef(),
-        dgBinding.getCRef()
-        );
-      Exception::MaybeThrow();
+      char const *name;
+      Visit const *parent;
+    };
+
+    bool loadLocked( char const *name, char const *trigger, Visit const *parent = 0 )
+    {
+      if ( m_loaded.find( name ) )
+        return false;
+      for ( Visit const *visit = parent; visit; visit = visit->parent )
+      {
+        if ( strcmp( visit->name, name ) == 0 )
+          return false;
+      }
+      Visit visit;
+      visit.name = name;
+      visit.parent = parent;
+
+      // requirements first, so that the timing of an extension doesn't
+      // include the extensions it pulls in
+      if ( m_index )
+      {
+        int32_t extension = m_index->findExtension( name );
+        if ( extension >= 0 )
+        {
+          size_t length = strlen( name );
+          char *source = (char *)malloc( length + 10 );
+          memcpy( source, "require ", 8 );
+          memcpy( source + 8, name, length );
+          memcpy( source + 8 + length, ";", 2 );
+          Variant requirements = m_index->getRequiredExtensions_Variant( source );
+          free( source );
+          for ( uint32_t i=0; i<requirements.getArraySize(); ++i )
+          {
+            char const *required = requirements.getArrayElement( i )->getString_cstr();
+            if ( strcmp( required, name ) != 0 && m_deferred.find( required ) )
+              loadLocked( required, "require", &visit );
+          }
+        }
+      }
+
+      // a failed load throws before the extension is marked as loaded, so
+      // that it is retried by the next prepare()
+      double start = GetSeconds();
+      m_client.loadExtension( name );
+      m_loaded.intern( name );
+      if ( m_deferred.find( name ) )
+        --m_pendingCount;
+      Load load;
+      load.name = m_strings.intern( name );
+      load.trigger = m_strings.intern( trigger );
+      load.seconds = GetSeconds() - start;
+      m_loads = (Load *)realloc( m_loads, ( m_loadCount + 1 ) * sizeof(Load) );
+      m_loads[m_loadCount++] = load;
+      return true;
     }
 
-    DGBindingList getPreDescendBindingList()
+  public:
+
+    ExtensionLoader(
+      Client const &client,
+      ExtensionIndex const *index = 0
+      )
+      : m_client( client )
+      , m_index( index )
+      , m_deferredNames( 0 )
+      , m_deferredCount( 0 )
+      , m_pendingCount( 0 )
+      , m_loads( 0 )
+      , m_loadCount( 0 )
     {
-      ensureIsValid();
-      FEC_DGBindingListRef result = FEC_DGEventHandlerGetPreDescendBindingList(
-        getCRef()
-        );
-      Exception::MaybeThrow();
-      return DGBindingList( result );
     }
 
-    void appendPostDescendBinding( DGBinding const &dgBinding )
+    ~ExtensionLoader()
     {
-      ensureIsValid();
-      FEC_DGEventHandlerAppendPostDescendBinding(
-        getCRef(),
-        dgBinding.getCRef()
-        );
-      Exception::MaybeThrow();
+      free( m_deferredNames );
+      free( m_loads );
     }
-    
-    DGBindingList getPostDescendBindingList()
+
+    /// defers loading extension name until prepare() finds it is needed
+    void defer( char const *name )
     {
-      ensureIsValid();
-      FEC_DGBindingListRef result = FEC_DGEventHandlerGetPostDescendBindingList(
-        getCRef()
-        );
-      Exception::MaybeThrow();
-      return DGBindingList( result );
+      MutexLock lock( m_mutex );
+      if ( m_deferred.find( name ) || m_loaded.find( name ) )
+        return;
+      m_deferredNames = (char const **)realloc( m_deferredNames, ( m_deferredCount + 1 ) * sizeof(char const *) );
+      m_deferredNames[m_deferredCount++] = m_deferred.intern( name );
+      ++m_pendingCount;
     }
 
-    void setScope(
-      char const *nameCString,
-      DGNode const &dgNode
-      )
+    /// defers every extension of an array of names, as passed to the
+    /// Client constructor
+    void defer( Variant const &exts )
     {
-      ensureIsValid();
-      FEC_DGEventHandlerSetScope(
-        getCRef(),
-        nameCString,
-        dgNode.getCRef()
-        );
-      Exception::MaybeThrow();
+      for ( uint32_t i=0; exts.isArray() && i<exts.getArraySize(); ++i )
+      {
+        if ( exts.getArrayElement( i )->isString() )
+          defer( exts.getArrayElement( i )->getString_cstr() );
+      }
     }
 
-    void setScopeName(
-      char const *nameCString
-      )
+    /*!
+     * Loads the extensions sourceCode needs and returns how many were
+     * loaded by this call.  Call it before compiling the source.
+     */
+    uint32_t prepare( char const *sourceCode )
     {
-      ensureIsValid();
-      FEC_DGEventHandlerSetScopeName(
-        getCRef(),
-        nameCString
-        );
-      Exception::MaybeThrow();
+      MutexLock lock( m_mutex );
+      Prepare prepare;
+      prepare.loader = this;
+      prepare.count = 0;
+      prepare.trigger = "require";
+      KLParseRequires( sourceCode, &LoadRequired, &prepare );
+
+      if ( m_index && m_pendingCount > 0 )
+      {
+        char const *c = sourceCode;
+        while ( *c )
+        {
+          if ( !( ( *c >= 'a' && *c <= 'z' ) || ( *c >= 'A' && *c <= 'Z' ) || *c == '_' ) )
+          {
+            ++c;
+            continue;
+          }
+          char const *start = c;
+          while ( ( *c >= 'a' && *c <= 'z' ) || ( *c >= 'A' && *c <= 'Z' ) || ( *c >= '0' && *c <= '9' ) || *c == '_' )
+            ++c;
+          int32_t extension = m_index->findExtensionProvidingType( start, uint32_t( c - start ) );
+          if ( extension < 0 )
+            continue;
+          char const *extensionName = m_index->getExtensionName( uint32_t( extension ) );
+          if ( m_deferred.find( extensionName ) && loadLocked( extensionName, "type" ) )
+            ++prepare.count;
+        }
+      }
+      return prepare.count;
     }
 
-   char const *getScopeName()
+    /// loads extension name now, if it isn't loaded yet
+    void load( char const *name )
     {
-      ensureIsValid();
-      char const *str = FEC_DGEventHandlerGetScopeName_cstr(
-        getCRef()
-        );
-      Exception::MaybeThrow();
-      return str;
+      MutexLock lock( m_mutex );
+      loadLocked( name, "explicit" );
     }
 
-    void setSelector(
-      char const *targetCString,
-      DGBinding const &dgBinding
-      )
+    /// loads every deferred extension which isn't loaded yet
+    void loadAll()
     {
-      ensureIsValid();
-      FEC_DGEventHandlerSetSelector(
-        getCRef(),
-        targetCString,
-        dgBinding.getCRef()
-        );
-      Exception::MaybeThrow();
+      MutexLock lock( m_mutex );
+      for ( uint32_t i=0; i<m_deferredCount; ++i )
+        loadLocked( m_deferredNames[i], "explicit" );
     }
 
-    static DGEventHandler GetByName(
-      Client const &client,
-      char const *nameCString
-      )
+    bool isLoaded( char const *name )
     {
-      FEC_DGNamedObjectRef result = FEC_DGNamedObjectGetByName(
-        client.getCRef(),
-        nameCString,
-        "EventHandler"
-        );
-      Exception::MaybeThrow();
-      return DGEventHandler( result );
+      MutexLock lock( m_mutex );
+      return m_loaded.find( name ) != 0;
     }
 
-    Variant getChildEventHandlers_Variant()
+    /// returns the number of deferred extensions which are still not loaded
+    uint32_t getPendingCount()
     {
-      ensureIsValid();
-      FEC_Variant result = FEC_DGEventHandlerGetChildEventHandlers_Variant(
-        getCRef()
-        );
-      Exception::MaybeThrow();
-      return Variant( &result );
+      MutexLock lock( m_mutex );
+      return getPendingCountLocked();
     }
 
-    Variant getScopes_Variant()
+  private:
+
+    uint32_t getPendingCountLocked() const
     {
-      ensureIsValid();
-      FEC_Variant result = FEC_DGEventHandlerGetScopes_Variant(
-        getCRef()
-        );
-      Exception::MaybeThrow();
-      return Variant( &result );
+      return m_pendingCount;
     }
 
-    void removeScope(
-      char const *nameCString
-      )
+  public:
+
+    /*!
+     * Returns a dict of the loaded extensions, in load order, each with
+     * the "seconds" spent loading it and the "trigger" of the load:
+     * "require", "type" or "explicit".
+     */
+    Variant getTimings_Variant()
     {
-      ensureIsValid();
-      FEC_DGEventHandlerRemoveScope(
-        getCRef(),
-        nameCString
-        );
-      Exception::MaybeThrow();
+      MutexLock lock( m_mutex );
+      Variant result = Variant::CreateDict();
+      double total = 0.0;
+      Variant extensions = Variant::CreateDict();
+      for ( uint32_t i=0; i<m_loadCount; ++i )
+      {
+        Variant entry = Variant::CreateDict();
+        entry.setDictValue( "seconds", Variant::CreateFloat64( m_loads[i].seconds ) );
+        entry.setDictValue( "trigger", Variant::CreateString( m_loads[i].trigger ) );
+        extensions.setDictValue( m_loads[i].name, entry );
+        total += m_loads[i].seconds;
+      }
+      result.setDictValue( "extensions", extensions );
+      result.setDictValue( "totalSeconds", Variant::CreateFloat64( total ) );
+      result.setDictValue( "pending", Variant::CreateUInt32( getPendingCountLocked() ) );
+      return result;
     }
   };
-  
-  class DGEvent : public DGContainer
+
+  /*
+   * C++ - KL Execution
+   */
+
+  /*!
+   * A long-lived alternative to KLExecute() for running many small KL
+   * programs.  The executor owns a client, so loaded extensions stay
+   * resident, and it caches each program's compiled operator by source, so
+   * running the same program again skips compilation entirely.
+   *
+   * Programs use the same entry point as KLExecute(), `operator entry()`.
+   * KLExecuteFlags_NoOpt and KLExecuteFlags_Unguarded are properties of the
+   * client and are taken from the flags passed to the constructor;
+   * KLExecuteFlags_SingleThreaded may vary per call.  Any flag the client
+   * can't express (UseIR, the Show* dumps, GPU targets) makes execute()
+   * fall back to a one-shot KLExecute().
+   *
+   * The extensions passed to the constructor are loaded lazily through an
+   * ExtensionLoader, when the first program that needs them is compiled.
+   * Without an ExtensionIndex that is the first program requiring them by
+   * name; see ExtensionLoader.
+   *
+   * At most getCapacity() programs are cached; beyond that the least
+   * recently executed program is destroyed.
+   */
+  class KLExecutor
   {
-  protected:
-    
-    DGEvent( FEC_DGEventRef that )
-      : DGContainer( that )
+    struct Program
+    {
+      uint32_t hash;
+      char *filename;
+      char *sourceCode;
+      DGOperator dgOperator;
+      DGBinding dgBinding;
+      DGNode dgNode;
+      bool compiled;
+      Variant diagnostics;
+    };
+
+    KLExecuteFlags m_flags;
+    Client m_client;
+    Program **m_programs;
+    uint32_t m_programCount;
+    uint32_t m_capacity;
+    uint32_t m_nextId;
+    uint64_t m_hitCount;
+    uint64_t m_missCount;
+    KLExecuteReportCallback m_reportCallback;
+    void *m_reportUserdata;
+    Mutex m_mutex;
+    ExtensionLoader *m_loader;
+
+    KLExecutor( KLExecutor const & );
+    KLExecutor &operator =( KLExecutor const & );
+
+    static const uint32_t PersistentFlags =
+      KLExecuteFlags_Run | KLExecuteFlags_NoOpt | KLExecuteFlags_Unguarded | KLExecuteFlags_SingleThreaded;
+
+    static void Report( void *userdata, char const *data, uint32_t length )
     {
+      KLExecutor *executor = static_cast<KLExecutor *>( userdata );
+      if ( executor->m_reportCallback )
+        executor->m_reportCallback( executor->m_reportUserdata, data, length );
     }
-    
-  public:
-    
-    DGEvent()
+
+    static char *Duplicate( char const *cString )
     {
+      size_t length = strlen( cString ) + 1;
+      char *result = (char *)malloc( length );
+      memcpy( result, cString, length );
+      return result;
     }
-    
-    DGEvent(
-      Client const &client,
-      char const *nameCString
-      )
-      : DGContainer( FEC_DGEventCreate(
-        client.getCRef(),
-        nameCString
-        ) )
+
+    static bool HasErrors( Variant const &errors )
     {
+      if ( errors.isArray() )
+        return errors.getArraySize() > 0;
+      if ( errors.isDict() )
+        return !Variant::DictIter( errors ).isDone();
+      return false;
     }
-    
-    DGEvent( DGEvent const &that )
-      : DGContainer( that )
+
+    static Variant ErrorDiagnostic( char const *filename, char const *desc )
     {
+      Variant diagnostic = Variant::CreateDict();
+      diagnostic.setDictValue( "filename", Variant::CreateString( filename ) );
+      diagnostic.setDictValue( "line", Variant::CreateUInt32( 0 ) );
+      diagnostic.setDictValue( "column", Variant::CreateUInt32( 0 ) );
+      diagnostic.setDictValue( "level", Variant::CreateString( "error" ) );
+      diagnostic.setDictValue( "desc", Variant::CreateString( desc ) );
+      return diagnostic;
     }
-    
-    DGEvent &operator =( DGEvent const &that )
+
+    static void DestroyProgram( Program *program )
     {
-      set( that );
-      return *this;
+      if ( program->dgNode.isValid() )
+        program->dgNode.destroy();
+      if ( program->dgOperator.isValid() )
+        program->dgOperator.destroy();
+      free( program->filename );
+      free( program->sourceCode );
+      delete program;
     }
 
-    void removeEventHandler( DGEventHandler const &dgEventHandler )
+    // destroys the least recently used programs until at most count remain
+    void evict( uint32_t count )
     {
-      ensureIsValid();
-      FEC_DGEventRemoveEventHandler(
-        getCRef(),
-        dgEventHandler.getCRef()
-        );
-      Exception::MaybeThrow();
+      if ( m_programCount <= count )
+        return;
+      uint32_t evicted = m_programCount - count;
+      for ( uint32_t i=0; i<evicted; ++i )
+        DestroyProgram( m_programs[i] );
+      memmove( m_programs, m_programs + evicted, count * sizeof(Program *) );
+      m_programCount = count;
     }
-     
-    void appendEventHandler( DGEventHandler const &dgEventHandler )
+
+    // m_programs is kept in order of use, the most recently used last.
+    // returns 0, with the error in diagnostics, if loading the extensions
+    // the program needs failed; such programs aren't cached, so that the
+    // load is retried the next time the program runs
+    Program *lookup( char const *filename, char const *sourceCode, Variant &diagnostics )
     {
-      ensureIsValid();
-      FEC_DGEventAppendEventHandler(
-        getCRef(),
-        dgEventHandler.getCRef()
+      uint32_t hash = HashString( sourceCode );
+      for ( uint32_t i=0; i<m_programCount; ++i )
+      {
+        Program *program = m_programs[i];
+        if ( program->hash == hash
+          && strcmp( program->sourceCode, sourceCode ) == 0
+          && strcmp( program->filename, filename ) == 0 )
+        {
+          ++m_hitCount;
+          memmove( m_programs + i, m_programs + i + 1, ( m_programCount - i - 1 ) * sizeof(Program *) );
+          m_programs[m_programCount - 1] = program;
+          return program;
+        }
+      }
+      ++m_missCount;
+
+      try
+      {
+        m_loader->prepare( sourceCode );
+      }
+      catch ( Exception const &e )
+      {
+        diagnostics = Variant::CreateArray();
+        diagnostics.arrayAppend( ErrorDiagnostic( filename, e.getDesc_cstr() ) );
+        return 0;
+      }
+
+      evict( m_capacity - 1 );
+      Program *program = new Program;
+      program->hash = hash;
+      program->filename = Duplicate( filename );
+      program->sourceCode = Duplicate( sourceCode );
+      program->compiled = false;
+      m_programs = (Program **)realloc( m_programs, ( m_programCount + 1 ) * sizeof(Program *) );
+      m_programs[m_programCount++] = program;
+
+      char name[32];
+      sprintf( name, "klExecutor%u", unsigned( m_nextId++ ) );
+      try
+      {
+        program->dgOperator = DGOperator( m_client, name, filename, sourceCode, "entry" );
+        program->dgBinding = DGBinding( program->dgOperator, 0, 0 );
+        program->diagnostics = program->dgOperator.getDiagnostics();
+        program->compiled = !HasErrors( program->dgOperator.getErrors() )
+          && !HasErrors( program->dgBinding.getErrors() );
+        if ( program->compiled )
+        {
+          program->dgNode = DGNode( m_client, name );
+          program->dgNode.appendBinding( program->dgBinding );
+        }
+      }
+      catch ( Exception const &e )
+      {
+        program->diagnostics = Variant::CreateArray();
+        program->diagnostics.arrayAppend( ErrorDiagnostic( filename, e.getDesc_cstr() ) );
+      }
+      return program;
+    }
+
+  public:
+
+    KLExecutor(
+      KLExecuteFlags klExecuteFlags = 0,
+      Variant *exts = 0,
+      ExtensionIndex const *index = 0
+      )
+      : m_flags( klExecuteFlags )
+      , m_programs( 0 )
+      , m_programCount( 0 )
+      , m_capacity( 64 )
+      , m_nextId( 0 )
+      , m_hitCount( 0 )
+      , m_missCount( 0 )
+      , m_reportCallback( 0 )
+      , m_reportUserdata( 0 )
+    {
+      m_client = Client(
+        !( klExecuteFlags & KLExecuteFlags_Unguarded ),
+        ( klExecuteFlags & KLExecuteFlags_NoOpt ) ? ClientOptimizationType_None : ClientOptimizationType_Background,
+        0,
+        &Report,
+        this
         );
-      Exception::MaybeThrow();
+      m_loader = new ExtensionLoader( m_client, index );
+      if ( exts )
+        m_loader->defer( *exts );
     }
-    
-    void fire()
+
+    ~KLExecutor()
     {
-      ensureIsValid();
-      FEC_DGEventFire(
-        getCRef()
-        );
-      Exception::MaybeThrow();
+      clear();
+      delete m_loader;
     }
 
-    void setSelectType(
-      char const *typeCString
+    Client const &getClient() const
+    {
+      return m_client;
+    }
+
+    ExtensionLoader &getExtensionLoader()
+    {
+      return *m_loader;
+    }
+
+    /*!
+     * Compiles sourceCodeCStr, or reuses its cached compilation, and runs
+     * it if it compiled without errors.  Same contract as KLExecute().
+     */
+    bool execute(
+      char const *filenameCStr,
+      char const *sourceCodeCStr,
+      KLExecuteFlags klExecuteFlags,
+      Variant &diagnostics,
+      KLExecuteReportCallback reportCallback,
+      void *reportUserdata
       )
     {
-      ensureIsValid();
-      FEC_DGEventSetSelectType(
-        getCRef(),
-        typeCString
-        );
-      Exception::MaybeThrow();
+      if ( ( klExecuteFlags & ~PersistentFlags ) != 0
+        || ( klExecuteFlags & ( KLExecuteFlags_NoOpt | KLExecuteFlags_Unguarded ) )
+          != ( m_flags & ( KLExecuteFlags_NoOpt | KLExecuteFlags_Unguarded ) ) )
+        return KLExecute( filenameCStr, sourceCodeCStr, klExecuteFlags, diagnostics, reportCallback, reportUserdata );
+
+      MutexLock lock( m_mutex );
+      Program *cached = lookup( filenameCStr, sourceCodeCStr, diagnostics );
+      if ( !cached )
+        return false;
+      Program &program = *cached;
+      diagnostics = program.diagnostics;
+      if ( !program.compiled )
+        return false;
+      if ( !( klExecuteFlags & KLExecuteFlags_Run ) )
+        return true;
+
+      m_reportCallback = reportCallback;
+      m_reportUserdata = reportUserdata;
+      bool result = true;
+      try
+      {
+        program.dgOperator.setMainThreadOnly( ( klExecuteFlags & KLExecuteFlags_SingleThreaded ) != 0 );
+        program.dgNode.evaluate();
+      }
+      catch ( Exception const &e )
+      {
+        diagnostics = Variant::CreateArray();
+        diagnostics.arrayAppend( ErrorDiagnostic( filenameCStr, e.getDesc_cstr() ) );
+        result = false;
+      }
+      m_reportCallback = 0;
+      m_reportUserdata = 0;
+      return result;
     }
 
-    char const *getSelectType()
+    /*!
+     * Drops every cached program.  The client, and with it the loaded
+     * extensions, stays alive.
+     */
+    void clear()
     {
-      ensureIsValid();
-      char const *str = FEC_DGEventGetSelectType(
-        getCRef()
-        );
-      Exception::MaybeThrow();
-      return str;
+      MutexLock lock( m_mutex );
+      evict( 0 );
+      free( m_programs );
+      m_programs = 0;
     }
 
-    Variant select_Variant()
+    // sets the maximum number of cached programs, at least 1
+    void setCapacity( uint32_t capacity )
     {
-      ensureIsValid();
-      FEC_Variant result;
-      FEC_VariantInitWithDGEventSelect(
-        getCRef(),
-        &result
-        );
-      Exception::MaybeThrow();
-      return Variant( &result );
+      MutexLock lock( m_mutex );
+      m_capacity = capacity > 0 ? capacity : 1;
+      evict( m_capacity );
     }
 
-    Variant getEventHandlers_Variant()
+    uint32_t getCapacity() const
     {
-      ensureIsValid();
-      FEC_Variant result = FEC_DGEventGetEventHandlers_Variant(
-        getCRef()
-        );
-      Exception::MaybeThrow();
-      return Variant( &result );
+      return m_capacity;
     }
 
-    static DGEvent GetByName(
-      Client const &client,
-      char const *nameCString
-      )
+    uint32_t getProgramCount() const
     {
-      FEC_DGNamedObjectRef result = FEC_DGNamedObjectGetByName(
-        client.getCRef(),
-        nameCString,
-        "Event"
-        );
-      Exception::MaybeThrow();
-      return DGEvent( result );
+      return m_programCount;
+    }
+
+    uint64_t getCacheHitCount() const
+    {
+      return m_hitCount;
+    }
+
+    uint64_t getCacheMissCount() const
+    {
+      return m_missCount;
     }
   };
 }
@@ -53,7 +53,11 @@
 
 #ifdef __linux__
 # include <limits.h>
+# include <poll.h>
+# include <sys/inotify.h>
 #endif
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include <stdlib.h>
 #include <CreationCore.h>
@@ -222,6 +226,14 @@ namespace CreationSplice
       printf("%s\n", FECS_Logging_getError());
       throw Exception( FECS_Logging_getError() );
     }
+
+    /// throws an exception for an error detected on the C++ side.
+    /// the message has to outlive the exception, so pass a string literal
+    static void Throw(const char * message)
+    {
+      printf("%s\n", message);
+      throw Exception( message );
+    }
   };
 
   inline void Initialize()
@@ -230,11 +242,7 @@ namespace CreationSplice
     Exception::MaybeThrow();
   }
 
-  inline void Finalize()
-  {
-    FECS_Finalize();
-    Exception::MaybeThrow();
-  }
+  inline void Finalize();
 
   inline bool isLicenseValid()
   {
@@ -257,16 +265,265 @@ namespace CreationSplice
     return result;
   }
 
+  /// narrows the extensions and RTs the runtime accepts to what the scene
+  /// uses. addExtFolder and addRTFolder index their folders through a
+  /// CreationCore::ExtensionIndex before registering them with the runtime,
+  /// which still discovers everything below them. once enable() is called
+  /// the extension and RT filters of the runtime only accept what has been
+  /// required so far: the extensions named by `require` statements of the
+  /// KL sources set on nodes, including indirect requirements, and the
+  /// types used by their members and sources along with the extensions
+  /// declaring them. operator sources, source files, persistence data and
+  /// reloads of KLOperatorFileWatcher are all required before they reach
+  /// the runtime. names the index doesn't know are always accepted. filters
+  /// set through Node::setExtFilter and Node::setRTFilter are applied on top
+  class ExtensionDiscovery
+  {
+  public:
+
+    /// installs the filters
+    static void enable()
+    {
+      State & state = get();
+      state.mEnabled = true;
+      FECS_Node_setExtFilter(&extFilter);
+      FECS_Node_setRTFilter(&rtFilter);
+    }
+
+    /// returns true if enable() was called
+    static bool isEnabled()
+    {
+      return get().mEnabled;
+    }
+
+    /// indexes a folder, see CreationCore::ExtensionIndex::addFolder
+    static bool addFolder(const char * folder)
+    {
+      State & state = get();
+      CreationCore::MutexLock lock(state.mMutex);
+      return state.mIndex.addFolder(folder);
+    }
+
+    /// accepts the extensions required by a KL source and the indexed
+    /// types it mentions along with the extensions declaring them
+    static void require(const char * sourceCode)
+    {
+      State & state = get();
+      CreationCore::MutexLock lock(state.mMutex);
+      CreationCore::Variant names = state.mIndex.getRequiredExtensions_Variant(sourceCode);
+      for(uint32_t i=0;i<names.getArraySize();i++)
+        state.mExtensions.intern(*names.getArrayElement(i));
+
+      const char * c = sourceCode;
+      while(*c)
+      {
+        if(!isIdentifierChar(*c))
+        {
+          c++;
+          continue;
+        }
+        const char * start = c;
+        while(isIdentifierChar(*c))
+          c++;
+        CreationCore::SmallString name(start, uint32_t(c - start));
+        int32_t extension = state.mIndex.findExtensionProvidingType(name.getCString());
+        if(extension < 0)
+          continue;
+        state.mTypes.intern(name.getCString());
+        state.mExtensions.intern(state.mIndex.getExtensionName(uint32_t(extension)));
+      }
+    }
+
+    /// accepts what the KL source in filePath requires
+    static void requireFile(const char * filePath)
+    {
+      char * sourceCode = readFile(filePath);
+      if(sourceCode == NULL)
+        return;
+      require(sourceCode);
+      free(sourceCode);
+    }
+
+    /// accepts what the KL sources and member types of persistence data
+    /// require, given as a decoded variant or as a JSON string
+    static void requireData(const CreationCore::Variant & json)
+    {
+      if(json.isDict())
+      {
+        for(CreationCore::Variant::DictIter it(json);!it.isDone();it.next())
+          requireData(*it.getValue());
+      }
+      else if(json.isArray())
+      {
+        for(uint32_t i=0;i<json.getArraySize();i++)
+          requireData(*json.getArrayElement(i));
+      }
+      else if(json.isString())
+      {
+        const char * data = json.getStringData();
+        uint32_t length = json.getStringLength();
+        while(length > 0 && (*data == ' ' || *data == '\t' || *data == '\n' || *data == '\r'))
+        {
+          data++;
+          length--;
+        }
+        if(length > 0 && (*data == '{' || *data == '['))
+        {
+          CreationCore::Variant decoded;
+          try
+          {
+            decoded = CreationCore::Variant::CreateFromJSON(data, length);
+          }
+          catch(CreationCore::Exception const &)
+          {
+          }
+          if(decoded.isDict() || decoded.isArray())
+          {
+            requireData(decoded);
+            return;
+          }
+        }
+        require(json.getString_cstr());
+      }
+    }
+
+    /// accepts what the persistence data in filePath requires
+    static void requireDataFile(const char * filePath)
+    {
+      char * data = readFile(filePath);
+      if(data == NULL)
+        return;
+      requireData(CreationCore::Variant::CreateString(data));
+      free(data);
+    }
+
+    /// accepts the type of a member, such as "Vec3[]"
+    static void requireType(const char * rt)
+    {
+      State & state = get();
+      CreationCore::MutexLock lock(state.mMutex);
+      const char * end = rt;
+      while(isIdentifierChar(*end))
+        end++;
+      CreationCore::SmallString name(rt, uint32_t(end - rt));
+      state.mTypes.intern(name.getCString());
+      int32_t extension = state.mIndex.findExtensionProvidingType(name.getCString());
+      if(extension >= 0)
+        state.mExtensions.intern(state.mIndex.getExtensionName(uint32_t(extension)));
+    }
+
+    /// sets the filter applied on top of the required extensions
+    static void setExtFilter(FECS_FilterFunc filter)
+    {
+      State & state = get();
+      state.mExtFilter = filter;
+      if(!state.mEnabled)
+        FECS_Node_setExtFilter(filter);
+    }
+
+    /// sets the filter applied on top of the required types
+    static void setRTFilter(FECS_FilterFunc filter)
+    {
+      State & state = get();
+      state.mRTFilter = filter;
+      if(!state.mEnabled)
+        FECS_Node_setRTFilter(filter);
+    }
+
+    /// returns the number of indexed extensions
+    static unsigned int getIndexedExtensionCount()
+    {
+      State & state = get();
+      CreationCore::MutexLock lock(state.mMutex);
+      return state.mIndex.getExtensionCount();
+    }
+
+  private:
+
+    struct State
+    {
+      CreationCore::Mutex mMutex;
+      CreationCore::ExtensionIndex mIndex;
+      CreationCore::StringPool mExtensions;
+      CreationCore::StringPool mTypes;
+      FECS_FilterFunc mExtFilter;
+      FECS_FilterFunc mRTFilter;
+      bool mEnabled;
+
+      State()
+      {
+        mExtFilter = NULL;
+        mRTFilter = NULL;
+        mEnabled = false;
+      }
+    };
+
+    static State & get()
+    {
+      static State state;
+      return state;
+    }
+
+    static bool isIdentifierChar(char c)
+    {
+      return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+
+    static char * readFile(const char * filePath)
+    {
+      FILE * file = fopen(filePath, "rb");
+      if(file == NULL)
+        return NULL;
+      fseek(file, 0, SEEK_END);
+      long length = ftell(file);
+      fseek(file, 0, SEEK_SET);
+      if(length < 0)
+      {
+        fclose(file);
+        return NULL;
+      }
+      char * result = (char *)malloc(size_t(length) + 1);
+      size_t read = fread(result, 1, size_t(length), file);
+      result[read] = '\0';
+      fclose(file);
+      return result;
+    }
+
+    static bool extFilter(const char * name)
+    {
+      State & state = get();
+      if(state.mExtFilter != NULL && !state.mExtFilter(name))
+        return false;
+      CreationCore::MutexLock lock(state.mMutex);
+      return state.mIndex.findExtension(name) < 0 || state.mExtensions.find(name) != NULL;
+    }
+
+    static bool rtFilter(const char * name)
+    {
+      State & state = get();
+      if(state.mRTFilter != NULL && !state.mRTFilter(name))
+        return false;
+      CreationCore::MutexLock lock(state.mMutex);
+      return state.mIndex.findExtensionProvidingType(name) < 0 || state.mTypes.find(name) != NULL;
+    }
+  };
+
+  /// adds a folder of RTs, which is also indexed for ExtensionDiscovery
   inline bool addRTFolder(const char * folder)
   {
+    ExtensionDiscovery::addFolder(folder);
     bool result = FECS_addRTFolder(folder);
+    CreationCore::BumpRTGeneration();
     Exception::MaybeThrow();
     return result;
   }
 
+  /// adds a folder of extensions, which is also indexed for ExtensionDiscovery
   inline bool addExtFolder(const char * folder)
   {
+    ExtensionDiscovery::addFolder(folder);
     bool result = FECS_addExtFolder(folder);
+    CreationCore::BumpRTGeneration();
     Exception::MaybeThrow();
     return result;
   }
@@ -274,6 +531,7 @@ namespace CreationSplice
   inline bool setKLAlias(const char * alias, const char * rt)
   {
     bool result = FECS_setKLAlias(alias, rt);
+    CreationCore::BumpRTGeneration();
     Exception::MaybeThrow();
     return result;
   }
@@ -320,6 +578,525 @@ namespace CreationSplice
     }
   };
 
+  /*
+    Shallow KL types for the typed Port accessors
+  */
+
+# define FECS_STATIC_ASSERT(cond, name) typedef char FECS_static_assert_##name[(cond) ? 1 : -1]
+
+  struct Vec3
+  {
+    float x, y, z;
+  };
+
+  struct Vec4
+  {
+    float x, y, z, t;
+  };
+
+  struct Mat44
+  {
+    Vec4 row0, row1, row2, row3;
+  };
+
+  FECS_STATIC_ASSERT(sizeof(Vec3) == 12, Vec3_size);
+  FECS_STATIC_ASSERT(sizeof(Vec4) == 16, Vec4_size);
+  FECS_STATIC_ASSERT(sizeof(Mat44) == 64, Mat44_size);
+
+# undef FECS_STATIC_ASSERT
+
+  /// maps a C++ type onto its KL registered type. only the specialized
+  /// types can be used with the typed Port accessors, anything else fails
+  /// to compile.
+  template<typename T> struct RTTraits;
+
+  template<> struct RTTraits<float>    { static const char * name() { return "Float32"; } };
+  template<> struct RTTraits<double>   { static const char * name() { return "Float64"; } };
+  template<> struct RTTraits<int32_t>  { static const char * name() { return "SInt32"; } };
+  template<> struct RTTraits<uint32_t> { static const char * name() { return "UInt32"; } };
+  template<> struct RTTraits<Vec3>     { static const char * name() { return "Vec3"; } };
+  template<> struct RTTraits<Vec4>     { static const char * name() { return "Vec4"; } };
+  template<> struct RTTraits<Mat44>    { static const char * name() { return "Mat44"; } };
+
+  /// an owning, resizable buffer of shallow KL values. storage comes from
+  /// CreationCore::BufferAllocator::Default(), so large buffers follow its
+  /// huge page and first-touch policy.
+  template<typename T>
+  class PortArray
+  {
+  public:
+
+    PortArray()
+    {
+      mData = NULL;
+      mCount = 0;
+      mCapacity = 0;
+    }
+
+    PortArray(PortArray const & other)
+    {
+      mData = NULL;
+      mCount = 0;
+      mCapacity = 0;
+      resize(other.mCount);
+      if(mCount > 0)
+        memcpy(mData, other.mData, sizeof(T) * mCount);
+    }
+
+    PortArray & operator =( PortArray const & other )
+    {
+      if(this != &other)
+      {
+        resize(other.mCount);
+        if(mCount > 0)
+          memcpy(mData, other.mData, sizeof(T) * mCount);
+      }
+      return *this;
+    }
+
+    ~PortArray()
+    {
+      CreationCore::BufferAllocator::Default().deallocate(mData);
+    }
+
+    /// resizes the buffer, keeping the allocation when shrinking
+    void resize(unsigned int count)
+    {
+      if(count > mCapacity)
+      {
+        T * data = (T*)CreationCore::BufferAllocator::Default().reallocate(mData, (uint64_t)sizeof(T) * count);
+        if(data == NULL)
+          Exception::Throw("PortArray: out of memory");
+        mData = data;
+        mCapacity = count;
+      }
+      mCount = count;
+    }
+
+    unsigned int getCount() const
+    {
+      return mCount;
+    }
+
+    unsigned int getByteSize() const
+    {
+      return mCount * sizeof(T);
+    }
+
+    T * getData()
+    {
+      return mData;
+    }
+
+    const T * getData() const
+    {
+      return mData;
+    }
+
+    T & operator [](unsigned int index)
+    {
+      return mData[index];
+    }
+
+    const T & operator [](unsigned int index) const
+    {
+      return mData[index];
+    }
+
+  private:
+    T * mData;
+    unsigned int mCount;
+    unsigned int mCapacity;
+  };
+
+  /// the evaluation state shared by all Node objects wrapping the same node
+  /// and by the Ports they hand out. it records writes done through the
+  /// C++ interface, so that Node::evaluateIfDirty can skip nodes whose inputs and
+  /// upstream nodes have not changed since their last evaluation.
+  class NodeState
+  {
+  public:
+
+    NodeState()
+    {
+      mRefCount = 1;
+      mVersion = 1;
+      mEvaluatedVersion = 0;
+      mEvaluatedEpoch = 0;
+      mEvalCount = 0;
+      mUntracked = false;
+      mVisiting = false;
+      mUpstream = NULL;
+      mUpstreamSeen = NULL;
+      mUpstreamCount = 0;
+      mDirtyMembers = NULL;
+      mDirtyMemberCount = 0;
+      mProfileCount = 0;
+      mProfileSeconds = 0.0;
+      mOperators = NULL;
+      mOperatorCount = 0;
+      mRef = NULL;
+      mRefVersion = 0;
+      mNodeCount = 1;
+      mPromoted = false;
+      mPromotionPending = false;
+      mPrevState = NULL;
+      CreationCore::MutexLock lock(stateListMutex());
+      mNextState = stateList();
+      if(mNextState != NULL)
+        mNextState->mPrevState = this;
+      stateList() = this;
+    }
+
+    void retain()
+    {
+      mRefCount++;
+    }
+
+    static void release(NodeState * state)
+    {
+      if(state != NULL && --state->mRefCount == 0)
+        delete(state);
+    }
+
+    /// marks the whole node as changed
+    void markDirty()
+    {
+      mVersion++;
+      bumpWriteVersion();
+    }
+
+    /// marks a single member as written
+    void markMemberDirty(const char * member)
+    {
+      mVersion++;
+      bumpWriteVersion();
+      const char * handle = mMemberNames.intern(member);
+      for(unsigned int i=0;i<mDirtyMemberCount;i++)
+      {
+        if(mDirtyMembers[i] == handle)
+          return;
+      }
+      mDirtyMembers = (const char **)realloc(mDirtyMembers, sizeof(const char *) * (mDirtyMemberCount + 1));
+      mDirtyMembers[mDirtyMemberCount++] = handle;
+    }
+
+    /// returns true if a member has been written since the last evaluation
+    bool isMemberDirty(const char * member) const
+    {
+      const char * handle = mMemberNames.find(member);
+      for(unsigned int i=0;handle != NULL && i<mDirtyMemberCount;i++)
+      {
+        if(mDirtyMembers[i] == handle)
+          return true;
+      }
+      return false;
+    }
+
+    unsigned int getDirtyMemberCount() const
+    {
+      return mDirtyMemberCount;
+    }
+
+    const char * getDirtyMember(unsigned int index) const
+    {
+      return mDirtyMembers[index];
+    }
+
+    /// disables skipping for good, used once the node's data can be
+    /// modified behind the back of the C++ interface
+    void setUntracked()
+    {
+      mUntracked = true;
+    }
+
+    bool isUntracked() const
+    {
+      return mUntracked;
+    }
+
+    /// records that this node consumes data of another node
+    void addUpstream(NodeState * state)
+    {
+      if(state == NULL || state == this)
+        return;
+      for(unsigned int i=0;i<mUpstreamCount;i++)
+      {
+        if(mUpstream[i] == state)
+          return;
+      }
+      state->retain();
+      mUpstream = (NodeState **)realloc(mUpstream, sizeof(NodeState *) * (mUpstreamCount + 1));
+      mUpstreamSeen = (uint64_t *)realloc(mUpstreamSeen, sizeof(uint64_t) * (mUpstreamCount + 1));
+      mUpstream[mUpstreamCount] = state;
+      mUpstreamSeen[mUpstreamCount] = 0;
+      mUpstreamCount++;
+      markDirty();
+    }
+
+    /// returns true if this node or anything upstream of it changed since
+    /// the last evaluation
+    bool needsEvaluate()
+    {
+      if(mVisiting)
+        return false;
+      if(mUntracked || mEvaluatedVersion != mVersion || mEvaluatedEpoch != operatorEpoch())
+        return true;
+      bool result = false;
+      mVisiting = true;
+      for(unsigned int i=0;i<mUpstreamCount && !result;i++)
+        result = mUpstream[i]->mEvalCount != mUpstreamSeen[i] || mUpstream[i]->needsEvaluate();
+      mVisiting = false;
+      return result;
+    }
+
+    /// records an evaluation of this node, which also pulls all upstream nodes
+    void markEvaluated()
+    {
+      if(mVisiting)
+        return;
+      if(needsEvaluate())
+        mEvalCount++;
+      mVisiting = true;
+      for(unsigned int i=0;i<mUpstreamCount;i++)
+      {
+        mUpstream[i]->markEvaluated();
+        mUpstreamSeen[i] = mUpstream[i]->mEvalCount;
+      }
+      mVisiting = false;
+      mEvaluatedVersion = mVersion;
+      mEvaluatedEpoch = operatorEpoch();
+      mDirtyMemberCount = 0;
+      bumpWriteVersion();
+    }
+
+    /// returns the Splice node wrapped by the Nodes sharing this state.
+    /// the state holds a single reference to it, which is dropped along
+    /// with the last Node even if Ports keep the state alive
+    FECS_NodeRef getRef() const
+    {
+      return mRef;
+    }
+
+    /// returns a counter incremented whenever the node is replaced
+    uint64_t getRefVersion() const
+    {
+      return mRefVersion;
+    }
+
+    /// replaces the wrapped node, dropping the reference to the previous one
+    void setRef(FECS_NodeRef ref)
+    {
+      FECS_NodeRef previous = mRef;
+      mRef = ref;
+      mRefVersion++;
+      mContainerName = CreationCore::SmallString();
+      if(mRef != NULL)
+      {
+        CreationCore::DGNode dgNode;
+        FECS_Node_getDGNode(mRef, dgNode);
+        if(dgNode.isValid())
+          mContainerName = CreationCore::SmallString(dgNode.getName());
+      }
+      if(previous != NULL)
+        FECS_Node_destroy(previous);
+    }
+
+    /// counts the Nodes sharing this state
+    void retainNode()
+    {
+      mNodeCount++;
+    }
+
+    void releaseNode()
+    {
+      if(--mNodeCount != 0)
+        return;
+      releaseOperators();
+      setRef(NULL);
+    }
+
+    /// forgets the operator aliases recorded for this node, see KLOperatorRegistry
+    void releaseOperators();
+
+    /// records that the node has been rebuilt optimized by Node::promote
+    void setPromoted()
+    {
+      mPromoted = true;
+    }
+
+    bool isPromoted() const
+    {
+      return mPromoted;
+    }
+
+    /// records that the node crossed its tiering threshold, see Node::promotePending
+    void setPromotionPending(bool pending)
+    {
+      mPromotionPending = pending;
+    }
+
+    bool isPromotionPending() const
+    {
+      return mPromotionPending;
+    }
+
+    /// bumps the DGWriteVersions version of the wrapped DG node
+    void bumpWriteVersion()
+    {
+      if(!mContainerName.isEmpty())
+        CreationCore::DGWriteVersions::Bump(mContainerName.getCString());
+    }
+
+    /// accumulates the duration of an evaluation, used by tiered optimization
+    void recordEvaluationTime(double seconds)
+    {
+      mProfileCount++;
+      mProfileSeconds += seconds;
+    }
+
+    /// returns the number of evaluations recorded by recordEvaluationTime
+    uint64_t getProfileCount() const
+    {
+      return mProfileCount;
+    }
+
+    /// returns the total duration of the evaluations recorded by recordEvaluationTime
+    double getProfileSeconds() const
+    {
+      return mProfileSeconds;
+    }
+
+    /// invalidates every node, used when shared KL operators change
+    static void bumpOperatorEpoch()
+    {
+      operatorEpoch()++;
+    }
+
+    /// records that the node binds the KL operator name
+    void addOperator(const char * name)
+    {
+      const char * handle = operatorNames().intern(name);
+      if(hasOperator(handle))
+        return;
+      mOperators = (const char **)realloc(mOperators, sizeof(const char *) * (mOperatorCount + 1));
+      mOperators[mOperatorCount++] = handle;
+    }
+
+    /// records that the node no longer binds the KL operator name
+    void removeOperator(const char * name)
+    {
+      const char * handle = operatorNames().find(name);
+      for(unsigned int i=0;i<mOperatorCount;i++)
+      {
+        if(mOperators[i] == handle)
+        {
+          mOperators[i] = mOperators[--mOperatorCount];
+          return;
+        }
+      }
+    }
+
+    /// marks every node binding the KL operator name as changed, which
+    /// unlike bumpOperatorEpoch leaves all other nodes clean
+    static void markOperatorDirty(const char * name)
+    {
+      const char * handle = operatorNames().find(name);
+      if(handle == NULL)
+        return;
+      CreationCore::MutexLock lock(stateListMutex());
+      for(NodeState * state = stateList();state != NULL;state = state->mNextState)
+      {
+        if(state->hasOperator(handle))
+          state->markDirty();
+      }
+    }
+
+  private:
+    NodeState(NodeState const &);
+    NodeState & operator =(NodeState const &);
+
+    ~NodeState();
+
+    void destroy()
+    {
+      for(unsigned int i=0;i<mUpstreamCount;i++)
+        release(mUpstream[i]);
+      free(mUpstream);
+      free(mUpstreamSeen);
+      free(mDirtyMembers);
+      free(mOperators);
+      CreationCore::MutexLock lock(stateListMutex());
+      if(mPrevState != NULL)
+        mPrevState->mNextState = mNextState;
+      else
+        stateList() = mNextState;
+      if(mNextState != NULL)
+        mNextState->mPrevState = mPrevState;
+    }
+
+    bool hasOperator(const char * handle) const
+    {
+      for(unsigned int i=0;i<mOperatorCount;i++)
+      {
+        if(mOperators[i] == handle)
+          return true;
+      }
+      return false;
+    }
+
+    /// the list of all states, guarded by stateListMutex()
+    static NodeState *& stateList()
+    {
+      static NodeState * first = NULL;
+      return first;
+    }
+
+    static CreationCore::Mutex & stateListMutex()
+    {
+      static CreationCore::Mutex mutex;
+      return mutex;
+    }
+
+    static CreationCore::StringPool & operatorNames()
+    {
+      static CreationCore::StringPool names;
+      return names;
+    }
+
+    static uint64_t & operatorEpoch()
+    {
+      static uint64_t epoch = 1;
+      return epoch;
+    }
+
+    unsigned int mRefCount;
+    uint64_t mVersion;
+    uint64_t mEvaluatedVersion;
+    uint64_t mEvaluatedEpoch;
+    uint64_t mEvalCount;
+    bool mUntracked;
+    bool mVisiting;
+    NodeState ** mUpstream;
+    uint64_t * mUpstreamSeen;
+    unsigned int mUpstreamCount;
+    const char ** mDirtyMembers;
+    unsigned int mDirtyMemberCount;
+    CreationCore::StringPool mMemberNames;
+    uint64_t mProfileCount;
+    double mProfileSeconds;
+    const char ** mOperators;
+    unsigned int mOperatorCount;
+    FECS_NodeRef mRef;
+    uint64_t mRefVersion;
+    unsigned int mNodeCount;
+    bool mPromoted;
+    bool mPromotionPending;
+    CreationCore::SmallString mContainerName;
+    NodeState * mPrevState;
+    NodeState * mNextState;
+  };
+
   // forward declarations
   class Node;
 
@@ -332,23 +1109,43 @@ namespace CreationSplice
     Port()
     { 
       mRef = NULL;
+      mRefVersion = 0;
+      mOwner = NULL;
+      mCached = 0;
+      mDataSize = 0;
+      mShallow = false;
+      mLayoutGeneration = 0;
+      mCheckedType = NULL;
+      mCheckedIsArray = false;
     }
 
     Port(Port const & other)
     {
       mRef = FECS_Port_copy(other.mRef);
+      mRefVersion = other.mRefVersion;
+      mOwner = other.mOwner;
+      if(mOwner)
+        mOwner->retain();
+      copyCache(other);
     }
 
     Port & operator =( Port const & other )
     {
       FECS_Port_destroy(mRef);
       mRef = FECS_Port_copy(other.mRef);
+      mRefVersion = other.mRefVersion;
+      if(other.mOwner)
+        other.mOwner->retain();
+      NodeState::release(mOwner);
+      mOwner = other.mOwner;
+      copyCache(other);
       return *this;
     }
 
     ~Port()
     {
       FECS_Port_destroy(mRef);
+      NodeState::release(mOwner);
     }
 
     /// returns true if the object is valid
@@ -360,7 +1157,7 @@ namespace CreationSplice
     /// empties the content of the port
     void clear()
     {
-      FECS_Node_clear(mRef);
+      FECS_Node_clear(ref());
     }
 
     /*
@@ -371,7 +1168,7 @@ namespace CreationSplice
     CreationCore::Variant getName()
     {
       CreationCore::Variant result;
-      FECS_Port_getName(mRef, result);
+      FECS_Port_getName(ref(), result);
       Exception::MaybeThrow();
       return result;
     }
@@ -380,7 +1177,7 @@ namespace CreationSplice
     CreationCore::Variant getGroupName()
     {
       CreationCore::Variant result;
-      FECS_Port_getGroupName(mRef, result);
+      FECS_Port_getGroupName(ref(), result);
       Exception::MaybeThrow();
       return result;
     }
@@ -388,7 +1185,7 @@ namespace CreationSplice
     /// returns true if this port is part of a group
     bool isInsideGroup()
     {
-      bool result  = FECS_Port_isInsideGroup(mRef);
+      bool result  = FECS_Port_isInsideGroup(ref());
       Exception::MaybeThrow();
       return result;
     }
@@ -397,7 +1194,7 @@ namespace CreationSplice
     CreationCore::Variant getMember()
     {
       CreationCore::Variant result;
-      FECS_Port_getMember(mRef, result);
+      FECS_Port_getMember(ref(), result);
       Exception::MaybeThrow();
       return result;
     }
@@ -406,15 +1203,49 @@ namespace CreationSplice
     CreationCore::Variant getKey()
     {
       CreationCore::Variant result;
-      FECS_Port_getKey(mRef, result);
+      FECS_Port_getKey(ref(), result);
       Exception::MaybeThrow();
       return result;
     }
 
+    /// returns the name of this Port without allocating a new CreationCore::Variant.
+    /// the value is queried once and cached for the lifetime of the Port object
+    const char * getName_cstr()
+    {
+      if(!(mCached & Cached_Name))
+      {
+        mName.assign(getName());
+        mCached |= Cached_Name;
+      }
+      return mName.getCString();
+    }
+
+    /// returns the name of the member this Port is connected to, cached like getName_cstr
+    const char * getMember_cstr()
+    {
+      if(!(mCached & Cached_Member))
+      {
+        mMember.assign(getMember());
+        mCached |= Cached_Member;
+      }
+      return mMember.getCString();
+    }
+
+    /// returns the unique key of this Port, cached like getName_cstr
+    const char * getKey_cstr()
+    {
+      if(!(mCached & Cached_Key))
+      {
+        mKey.assign(getKey());
+        mCached |= Cached_Key;
+      }
+      return mKey.getCString();
+    }
+
     /// returns the mode of this Port
     Port_Mode getMode()
     {
-      Port_Mode result = (Port_Mode)FECS_Port_getMode(mRef);
+      Port_Mode result = (Port_Mode)FECS_Port_getMode(ref());
       Exception::MaybeThrow();
       return result;
     }
@@ -422,314 +1253,1870 @@ namespace CreationSplice
     /// sets the mode of this Port
     void setMode(Port_Mode mode)
     {
-      FECS_Port_setMode(mRef, mode);
+      FECS_Port_setMode(ref(), mode);
+      Exception::MaybeThrow();
+      mCached &= ~Cached_Key;
+    }
+
+    /// returns the data type of the member this Port is connected to
+    CreationCore::Variant getDataType()
+    {
+      CreationCore::Variant result;
+      FECS_Port_getDataType(ref(), result);
       Exception::MaybeThrow();
+      return result;
+    }
+
+    /// returns the data type of this Port, cached like getName_cstr
+    const char * getDataType_cstr()
+    {
+      if(!(mCached & Cached_DataType))
+      {
+        mDataType.assign(getDataType());
+        mCached |= Cached_DataType;
+      }
+      return mDataType.getCString();
+    }
+
+    /// returns the data size of a single element of the member this Port is connected to.
+    /// So for example, both for a 'Vec3' and 'Vec3[]' this will return sizeof(Vec3) == 12
+    /// the size is cached until an RT is registered again
+    unsigned int getDataSize()
+    {
+      cacheLayout();
+      return mDataSize;
+    }
+
+    /// returns true if the data type of this Port is shallow.
+    /// only shallow data types can be used with the high performance IO
+    bool isShallow()
+    {
+      cacheLayout();
+      return mShallow;
+    }
+
+    /// returns true if the data type of this Port is an array (Vec3[] for example)
+    bool isArray()
+    {
+      bool result = FECS_Port_isArray(ref());
+      Exception::MaybeThrow();
+      return result;
+    }
+
+    /*
+      Basic Data Setters
+    */
+
+    /// returns the name of the member this Port is connected to
+    void setGroupName(const char * name)
+    {
+      FECS_Port_setGroupName(ref(), name);
+      Exception::MaybeThrow();
+      mCached &= ~Cached_Key;
+    }
+
+    /*
+      CreationCore slicing management
+    */
+
+    /// returns the slice count of the CreationCore::DGNode this Port is connected to
+    unsigned int getSliceCount()
+    {
+      unsigned int result = FECS_Port_getSliceCount(ref()); 
+      Exception::MaybeThrow();
+      return result;
+    }
+
+    /// sets the slice count of the CreationCore::DGNode this Port is connected to
+    bool setSliceCount(unsigned int count)
+    {
+      bool result = FECS_Port_setSliceCount(ref(), count); 
+      if(mOwner)
+        mOwner->markDirty();
+      Exception::MaybeThrow();
+      return result;
+    }
+
+    /*
+      CreationCore::Variant IO
+    */
+
+    /// returns the value of a specific slice of this Port as a CreationCore::Variant
+    CreationCore::Variant getVariant(unsigned int slice = 0)
+    {
+      CreationCore::Variant result;
+      FECS_Port_getVariant(ref(), slice, result);
+      Exception::MaybeThrow();
+      return result;
+    }
+
+    /// sets the value of a specific slice of this Port from a CreationCore::Variant
+    bool setVariant(CreationCore::Variant value, unsigned int slice = 0)
+    {
+      bool result = FECS_Port_setVariant(ref(), value, slice);
+      touch();
+      Exception::MaybeThrow();
+      return result;
+    }
+
+    /// returns the value of a specific slice of this Port as a JSON string
+    CreationCore::Variant getJSON(unsigned int slice = 0)
+    {
+      CreationCore::Variant result;
+      FECS_Port_getJSON(ref(), slice, result);
+      Exception::MaybeThrow();
+      return result;
+    }
+
+    /// sets the value of a specific slice of this Port from a JSON string
+    bool setJSON(const char * json, unsigned int slice = 0)
+    {
+      bool result = FECS_Port_setJSON(ref(), json, slice);
+      touch();
+      Exception::MaybeThrow();
+      return result;
+    }
+
+    /// returns the default value of this Port as a CreationCore::Variant
+    CreationCore::Variant getDefault()
+    {
+      CreationCore::Variant result;
+      FECS_Port_getDefault(ref(), result);
+      Exception::MaybeThrow();
+      return result;
+    }
+
+    /*
+      High Performance IO
+      void* access to the internal data of the CreationCore::DGNode is only possible
+      for shallow data types (like Vec3 for example).
+    */
+
+    /// returns the size of an array member this Port is connected to
+    unsigned int getArrayCount(unsigned int slice = 0)
+    {
+      unsigned int result = FECS_Port_getArrayCount(ref(), slice);
+      Exception::MaybeThrow();
+      return result;
+    }
+
+    /// returns the void* array data of this Port.
+    /// this only works for array Ports (isArray() == true)
+    /// the bufferSize has to match getArrayCount() * getDataSize()
+    bool getArrayData(void * buffer, unsigned int bufferSize, unsigned int slice = 0)
+    {
+      bool result = FECS_Port_getArrayData(ref(), buffer, bufferSize, slice);
+      Exception::MaybeThrow();
+      return result;
+    }
+
+    /// sets the void* array data of this Port.
+    /// this only works for array Ports (isArray() == true)
+    /// this also sets the array count determined by bufferSize / getDataSize()
+    bool setArrayData(void * buffer, unsigned int bufferSize, unsigned int slice = 0)
+    {
+      bool result = FECS_Port_setArrayData(ref(), buffer, bufferSize, slice);
+      touch();
+      Exception::MaybeThrow();
+      return result;
+    }
+
+    /// gets the void* slice array data of this Port.
+    /// this only works for non-array Ports (isArray() == false)
+    /// the bufferSize has to match getSliceCount() * getDataSize()
+    bool getAllSlicesData(void * buffer, unsigned int bufferSize)
+    {
+      bool result = FECS_Port_getAllSlicesData(ref(), buffer, bufferSize);
+      Exception::MaybeThrow();
+      return result;
+    }
+
+    /// sets the void* slice array data of this Port.
+    /// this only works for non-array Ports (isArray() == false)
+    /// the bufferSize has to match getSliceCount() * getDataSize()
+    bool setAllSlicesData(void * buffer, unsigned int bufferSize)
+    {
+      bool result = FECS_Port_setAllSlicesData(ref(), buffer, bufferSize);
+      touch();
+      Exception::MaybeThrow();
+      return result;
+    }
+
+    /// set the array data based on another port
+    /// this performs data replication, and only works on shallow array data ports.
+    /// the data type has to match as well (so only Vec3 to Vec3 for example).
+    bool copyArrayDataFromPort(Port other, unsigned int slice = 0, unsigned int otherSlice = UINT_MAX)
+    {
+      bool result = FECS_Port_copyArrayDataFromPort(ref(), other.ref(), slice, otherSlice);
+      touch();
+      Exception::MaybeThrow();
+      return result;
+    }
+
+    /// set the slices data based on another port
+    /// this performs data replication, and only works on shallow non array data ports.
+    /// the data type has to match as well (so only Vec3 to Vec3 for example).
+    bool copyAllSlicesDataFromPort(Port other, bool resizeTarget = false)
+    {
+      bool result = FECS_Port_copyAllSlicesDataFromPort(ref(), other.ref(), resizeTarget);
+      touch();
+      Exception::MaybeThrow();
+      return result;
+    }
+
+    /*
+      Typed IO
+      these check sizeof(T) and the KL type name against the Port once, and
+      afterwards go straight to the high performance IO.
+    */
+
+    /// throws unless T matches the data type of this Port
+    template<typename T>
+    void checkType()
+    {
+      if(mCheckedType == RTTraits<T>::name())
+        return;
+      if(getDataSize() != sizeof(T))
+        Exception::Throw("Port::checkType: sizeof(T) does not match the RT size of the port");
+      const char * dataType = getDataType_cstr();
+      const char * name = RTTraits<T>::name();
+      size_t length = strlen(name);
+      if(strncmp(dataType, name, length) != 0 || (dataType[length] != '\0' && dataType[length] != '['))
+        Exception::Throw("Port::checkType: T does not match the data type of the port");
+      if(!isShallow())
+        Exception::Throw("Port::checkType: typed access requires a shallow data type");
+      mCheckedIsArray = isArray();
+      mCheckedType = name;
+    }
+
+    /// copies the array of a specific slice into a reusable buffer, returns the element count.
+    /// this only works for array Ports (isArray() == true)
+    template<typename T>
+    unsigned int read(PortArray<T> & result, unsigned int slice = 0)
+    {
+      checkType<T>();
+      if(!mCheckedIsArray)
+        Exception::Throw("Port::read: port is not an array");
+      result.resize(getArrayCount(slice));
+      if(result.getCount() > 0 && !getArrayData(result.getData(), result.getByteSize(), slice))
+        Exception::Throw("Port::read: getArrayData failed");
+      return result.getCount();
+    }
+
+    /// returns a copy of the array of a specific slice.
+    /// this only works for array Ports (isArray() == true)
+    template<typename T>
+    PortArray<T> read(unsigned int slice = 0)
+    {
+      PortArray<T> result;
+      read<T>(result, slice);
+      return result;
+    }
+
+    /// sets the array of a specific slice, including its size.
+    /// this only works for array Ports (isArray() == true)
+    template<typename T>
+    bool assign(const T * data, unsigned int count, unsigned int slice = 0)
+    {
+      checkType<T>();
+      if(!mCheckedIsArray)
+        Exception::Throw("Port::assign: port is not an array");
+      return setArrayData((void*)data, count * sizeof(T), slice);
+    }
+
+    template<typename T>
+    bool assign(const PortArray<T> & data, unsigned int slice = 0)
+    {
+      return assign<T>(data.getData(), data.getCount(), slice);
+    }
+
+    /// copies the arrays of the slices [begin, end) back to back into data,
+    /// with the element count of each slice in counts. returns the total
+    /// element count. this makes one getArrayData call per slice.
+    /// this only works for array Ports (isArray() == true)
+    template<typename T>
+    unsigned int readSlices(PortArray<T> & data, PortArray<unsigned int> & counts, unsigned int begin, unsigned int end)
+    {
+      checkType<T>();
+      if(!mCheckedIsArray)
+        Exception::Throw("Port::readSlices: port is not an array");
+      if(begin > end || end > getSliceCount())
+        Exception::Throw("Port::readSlices: slice range out of bounds");
+      counts.resize(end - begin);
+      unsigned int total = 0;
+      for(unsigned int i=begin;i<end;i++)
+      {
+        counts[i - begin] = getArrayCount(i);
+        total += counts[i - begin];
+      }
+      data.resize(total);
+      T * cursor = data.getData();
+      for(unsigned int i=begin;i<end;i++)
+      {
+        if(counts[i - begin] == 0)
+          continue;
+        if(!getArrayData(cursor, counts[i - begin] * sizeof(T), i))
+          Exception::Throw("Port::readSlices: getArrayData failed");
+        cursor += counts[i - begin];
+      }
+      return total;
+    }
+
+    /// sets the arrays of the slices [begin, end) from data packed back to
+    /// back, counts holding the element count of each slice. this makes one
+    /// setArrayData call per slice.
+    /// this only works for array Ports (isArray() == true)
+    template<typename T>
+    bool assignSlices(const T * data, const unsigned int * counts, unsigned int begin, unsigned int end)
+    {
+      checkType<T>();
+      if(!mCheckedIsArray)
+        Exception::Throw("Port::assignSlices: port is not an array");
+      if(begin > end || end > getSliceCount())
+        Exception::Throw("Port::assignSlices: slice range out of bounds");
+      bool result = true;
+      for(unsigned int i=begin;i<end;i++)
+      {
+        result = setArrayData((void*)data, counts[i - begin] * sizeof(T), i) && result;
+        data += counts[i - begin];
+      }
+      return result;
+    }
+
+    /// copies the data of all slices into a reusable buffer, returns the slice count.
+    /// this only works for non-array Ports (isArray() == false)
+    template<typename T>
+    unsigned int readAllSlices(PortArray<T> & result)
+    {
+      checkType<T>();
+      if(mCheckedIsArray)
+        Exception::Throw("Port::readAllSlices: port is an array");
+      result.resize(getSliceCount());
+      if(result.getCount() > 0 && !getAllSlicesData(result.getData(), result.getByteSize()))
+        Exception::Throw("Port::readAllSlices: getAllSlicesData failed");
+      return result.getCount();
+    }
+
+    /// sets the data of all slices. count has to match getSliceCount().
+    /// this only works for non-array Ports (isArray() == false)
+    template<typename T>
+    bool assignAllSlices(const T * data, unsigned int count)
+    {
+      checkType<T>();
+      if(mCheckedIsArray)
+        Exception::Throw("Port::assignAllSlices: port is an array");
+      return setAllSlicesData((void*)data, count * sizeof(T));
+    }
+
+    template<typename T>
+    bool assignAllSlices(const PortArray<T> & data)
+    {
+      return assignAllSlices<T>(data.getData(), data.getCount());
+    }
+
+    /*
+      Connection management
+    */
+
+    /// returns true if a port has connections
+    bool isConnected()
+    {
+      bool result = FECS_Port_isConnected(ref());
+      Exception::MaybeThrow();
+      return result;
+    }
+
+    /// connects one Port to another one
+    bool connect(Port other)
+    {
+      bool result = FECS_Port_connect(ref(), other.ref());
+      Exception::MaybeThrow();
+      if(result)
+        linkStates(other);
+      return result;
+    }
+
+    /// disconnects all connected Ports
+    bool disconnect()
+    {
+      bool result = FECS_Port_disconnect(ref());
+      if(mOwner)
+        mOwner->markDirty();
+      Exception::MaybeThrow();
+      return result;
+    }
+
+    /// return the number of connected ports
+    unsigned int getConnectionCount()
+    {
+      bool result = FECS_Port_getConnectionCount(ref());
+      Exception::MaybeThrow();
+      return result;
+    }
+
+    /// return a connected port
+    Port getConnection(unsigned int index)
+    {
+      Port connection;
+      connection.mRef = FECS_Port_getConnection(ref(), index);
+      Exception::MaybeThrow();
+      return connection;
+    }
+
+  private:
+    Port(FECS_PortRef ref, NodeState * owner = NULL)
+    { 
+      mRef = ref;
+      mOwner = owner;
+      mRefVersion = 0;
+      if(mOwner)
+      {
+        mOwner->retain();
+        mRefVersion = mOwner->getRefVersion();
+      }
+      mCached = 0;
+      mDataSize = 0;
+      mShallow = false;
+      mLayoutGeneration = 0;
+      mCheckedType = NULL;
+      mCheckedIsArray = false;
+    }
+
+    /// records the dependency between the nodes of two connected Ports,
+    /// based on the port modes. IO ports are treated as both directions.
+    void linkStates(Port & other)
+    {
+      if(mOwner == NULL || other.mOwner == NULL)
+        return;
+      Port_Mode mode = getMode();
+      Port_Mode otherMode = other.getMode();
+      if(mode != Port_Mode_OUT || otherMode != Port_Mode_IN)
+        mOwner->addUpstream(other.mOwner);
+      if(mode != Port_Mode_IN || otherMode != Port_Mode_OUT)
+        other.mOwner->addUpstream(mOwner);
+    }
+
+    /// returns the port reference. once Node::promote has replaced the
+    /// owner's node, the port of the same name on the new node is looked
+    /// up on first use
+    FECS_PortRef ref()
+    {
+      if(mOwner != NULL && mRefVersion != mOwner->getRefVersion())
+        rebind();
+      return mRef;
+    }
+
+    void rebind()
+    {
+      mRefVersion = mOwner->getRefVersion();
+      if(mOwner->getRef() == NULL || mRef == NULL)
+        return;
+      CreationCore::Variant name;
+      FECS_Port_getName(mRef, name);
+      Exception::MaybeThrow();
+      FECS_PortRef port = FECS_Node_getPort(mOwner->getRef(), name.getString_cstr());
+      Exception::MaybeThrow();
+      if(port == NULL)
+        return;
+      FECS_Port_destroy(mRef);
+      mRef = port;
+      mCached = 0;
+      mCheckedType = NULL;
+    }
+
+    /// records a write to the member of this Port for the dirty tracking
+    void touch()
+    {
+      if(mOwner)
+        mOwner->markMemberDirty(getMember_cstr());
+    }
+
+    /// queries the data size and shallowness, unless they are cached for
+    /// the current RT generation
+    void cacheLayout()
+    {
+      if((mCached & Cached_Layout) && mLayoutGeneration == CreationCore::RTGeneration())
+        return;
+      mDataSize = FECS_Port_getDataSize(ref());
+      Exception::MaybeThrow();
+      mShallow = FECS_Port_isShallow(ref());
+      Exception::MaybeThrow();
+      mLayoutGeneration = CreationCore::RTGeneration();
+      mCached |= Cached_Layout;
+    }
+
+    void copyCache(Port const & other)
+    {
+      mCached = other.mCached;
+      mDataSize = other.mDataSize;
+      mShallow = other.mShallow;
+      mLayoutGeneration = other.mLayoutGeneration;
+      mCheckedType = other.mCheckedType;
+      mCheckedIsArray = other.mCheckedIsArray;
+      if(mCached & Cached_Name)
+        mName = other.mName;
+      if(mCached & Cached_Member)
+        mMember = other.mMember;
+      if(mCached & Cached_Key)
+        mKey = other.mKey;
+      if(mCached & Cached_DataType)
+        mDataType = other.mDataType;
+    }
+
+    enum
+    {
+      Cached_Name = 1 << 0,
+      Cached_Member = 1 << 1,
+      Cached_Key = 1 << 2,
+      Cached_DataType = 1 << 3,
+      Cached_Layout = 1 << 4
+    };
+
+    FECS_PortRef mRef;
+    uint64_t mRefVersion;
+    NodeState * mOwner;
+    unsigned int mCached;
+    CreationCore::SmallString mName;
+    CreationCore::SmallString mMember;
+    CreationCore::SmallString mKey;
+    CreationCore::SmallString mDataType;
+    unsigned int mDataSize;
+    bool mShallow;
+    uint64_t mLayoutGeneration;
+    const char * mCheckedType;
+    bool mCheckedIsArray;
+  };
+
+  /// the name-to-port index kept by a Node. the Ports are owned by the
+  /// cache and stay valid until the port layout of the node changes.
+  class NodePortCache
+  {
+  public:
+
+    NodePortCache()
+    {
+      mEntries = NULL;
+      mCount = 0;
+      mCapacity = 0;
+      mBuckets = NULL;
+      mBucketMask = 0;
+    }
+
+    ~NodePortCache()
+    {
+      clear();
     }
 
-    /// returns the data type of the member this Port is connected to
-    CreationCore::Variant getDataType()
+    /// drops all cached ports
+    void clear()
     {
-      CreationCore::Variant result;
-      FECS_Port_getDataType(mRef, result);
-      Exception::MaybeThrow();
-      return result;
+      for(unsigned int i=0;i<mCount;i++)
+        delete(mEntries[i].port);
+      free(mEntries);
+      free(mBuckets);
+      mEntries = NULL;
+      mCount = 0;
+      mCapacity = 0;
+      mBuckets = NULL;
+      mBucketMask = 0;
+    }
+
+    /// appends a port. the cache takes ownership of it
+    void append(const char * name, Port * port)
+    {
+      if(mCount == mCapacity)
+      {
+        unsigned int capacity = mCapacity ? mCapacity * 2 : 16;
+        Entry * entries = (Entry*)realloc(mEntries, sizeof(Entry) * capacity);
+        if(entries == NULL)
+        {
+          delete(port);
+          Exception::Throw("NodePortCache: out of memory");
+        }
+        mEntries = entries;
+        mCapacity = capacity;
+      }
+      Entry & entry = mEntries[mCount++];
+      entry.name = mNames.intern(name);
+      entry.port = port;
+    }
+
+    /// builds the hash index once all ports have been appended
+    void finalize()
+    {
+      unsigned int bucketCount = 16;
+      while(bucketCount < mCount * 2)
+        bucketCount *= 2;
+      free(mBuckets);
+      mBuckets = (unsigned int*)calloc(bucketCount, sizeof(unsigned int));
+      if(mBuckets == NULL)
+      {
+        mBucketMask = 0;
+        Exception::Throw("NodePortCache: out of memory");
+      }
+      mBucketMask = bucketCount - 1;
+      for(unsigned int i=0;i<mCount;i++)
+      {
+        unsigned int bucket = hashHandle(mEntries[i].name) & mBucketMask;
+        while(mBuckets[bucket])
+          bucket = (bucket + 1) & mBucketMask;
+        mBuckets[bucket] = i + 1;
+      }
+    }
+
+    /// returns the index of a port by name, or -1. the name is hashed once
+    /// by the string pool, the index is keyed off the interned pointer
+    int find(const char * name) const
+    {
+      if(mCount == 0 || mBuckets == NULL)
+        return -1;
+      const char * handle = mNames.find(name);
+      if(handle == NULL)
+        return -1;
+      unsigned int bucket = hashHandle(handle) & mBucketMask;
+      while(unsigned int slot = mBuckets[bucket])
+      {
+        if(mEntries[slot-1].name == handle)
+          return int(slot - 1);
+        bucket = (bucket + 1) & mBucketMask;
+      }
+      return -1;
+    }
+
+    unsigned int getCount() const
+    {
+      return mCount;
+    }
+
+    const char * getName(unsigned int index) const
+    {
+      return mEntries[index].name;
+    }
+
+    Port & getPort(unsigned int index)
+    {
+      return *mEntries[index].port;
     }
 
-    /// returns the data size of a single element of the member this Port is connected to.
-    /// So for example, both for a 'Vec3' and 'Vec3[]' this will return sizeof(Vec3) == 12
-    unsigned int getDataSize()
+  private:
+    NodePortCache(NodePortCache const &);
+    NodePortCache & operator =(NodePortCache const &);
+
+    static unsigned int hashHandle(const char * handle)
     {
-      unsigned int result = FECS_Port_getDataSize(mRef);
-      Exception::MaybeThrow();
-      return result;
+      size_t value = size_t(handle);
+      return (unsigned int)(value ^ (value >> 16)) * 2654435761u;
     }
 
-    /// returns true if the data type of this Port is shallow.
-    /// only shallow data types can be used with the high performance IO
-    bool isShallow()
+    struct Entry
     {
-      bool result = FECS_Port_isShallow(mRef);
-      Exception::MaybeThrow();
+      const char * name;
+      Port * port;
+    };
+
+    Entry * mEntries;
+    unsigned int mCount;
+    unsigned int mCapacity;
+    unsigned int * mBuckets;
+    unsigned int mBucketMask;
+    CreationCore::StringPool mNames;
+  };
+
+  /// the process wide registry which lets KL operators with the same source
+  /// share one compiled operator. sources are compared after normalization:
+  /// comments and insignificant whitespace are dropped and the operator's
+  /// own name is replaced, so a duplicated SOP whose operator only differs
+  /// by name binds the operator compiled first. the first name constructed
+  /// for a source is its canonical name, later names are aliases which
+  /// are recorded per node. editing the source of a shared name gives
+  /// every alias involved its own operator again.
+  class KLOperatorRegistry
+  {
+  public:
+
+    /// constructs operator name on the node of state, binding an already
+    /// compiled operator with the same normalized source if there is one.
+    /// aliases are recorded per NodeState, which releases them once the
+    /// node is cleared or gone. compiled is set if a new source had to be
+    /// compiled rather than bound or reused
+    static bool construct(NodeState * state, const char * name, const char * sourceCode, bool * compiled = NULL)
+    {
+      if(compiled != NULL)
+        *compiled = false;
+      FECS_NodeRef node = state->getRef();
+      CreationCore::MutexLock lock(mutex());
+      Registry & registry = get();
+
+      Alias * alias = registry.findAlias(name);
+      if(alias != NULL && (sourceCode == NULL || sourceCode[0] == '\0' ||
+        strcmp(alias->mSourceCode, sourceCode) == 0))
+      {
+        bool result = FECS_Node_constructKLOperator(node, alias->mSource->mCanonical, "");
+        if(result && !alias->hasNode(state))
+        {
+          alias->addNode(state);
+          alias->mSource->mRefs++;
+        }
+        return result;
+      }
+      if(alias != NULL)
+        registry.unshare(name);
+
+      if(sourceCode == NULL || sourceCode[0] == '\0')
+        return FECS_Node_constructKLOperator(node, name, sourceCode);
+
+      char * normalized = normalize(sourceCode, name);
+      uint32_t hash = CreationCore::HashString(normalized);
+      Source * source = registry.findSource(hash, normalized);
+      if(source != NULL && strcmp(source->mCanonical, name) != 0)
+      {
+        free(normalized);
+        bool result = FECS_Node_constructKLOperator(node, source->mCanonical, "");
+        if(result)
+        {
+          alias = registry.findAlias(name);
+          if(alias == NULL)
+            alias = registry.addAlias(name, sourceCode, source);
+          if(!alias->hasNode(state))
+          {
+            alias->addNode(state);
+            source->mRefs++;
+          }
+        }
+        return result;
+      }
+
+      bool result = FECS_Node_constructKLOperator(node, name, sourceCode);
+      if(result && source != NULL)
+        source->mRefs++;
+      else if(result)
+      {
+        registry.unshare(name);
+        registry.addSource(hash, normalized, name);
+        normalized = NULL;
+        if(compiled != NULL)
+          *compiled = true;
+      }
+      free(normalized);
       return result;
     }
 
-    /// returns true if the data type of this Port is an array (Vec3[] for example)
-    bool isArray()
-    {
-      bool result = FECS_Port_isArray(mRef);
-      Exception::MaybeThrow();
+    /// removes operator name from the node of state, releasing the shared operator
+    static bool remove(NodeState * state, const char * name)
+    {
+      FECS_NodeRef node = state->getRef();
+      CreationCore::MutexLock lock(mutex());
+      Registry & registry = get();
+
+      Alias * alias = registry.findAlias(name);
+      if(alias != NULL && alias->hasNode(state))
+      {
+        Source * source = alias->mSource;
+        bool result = FECS_Node_removeKLOperator(node, source->mCanonical);
+        alias->removeNode(state);
+        if(alias->mNodeCount == 0)
+          registry.removeAlias(alias);
+        registry.release(source);
+        return result;
+      }
+
+      bool result = FECS_Node_removeKLOperator(node, name);
+      Source * source = registry.findCanonical(name);
+      if(result && source != NULL)
+        registry.release(source);
       return result;
     }
 
-    /*
-      Basic Data Setters
-    */
-
-    /// returns the name of the member this Port is connected to
-    void setGroupName(const char * name)
+    /// gives name its own operator again, so that it can be edited without
+    /// affecting the other names sharing its source
+    static void unshare(const char * name)
     {
-      FECS_Port_setGroupName(mRef, name);
-      Exception::MaybeThrow();
+      CreationCore::MutexLock lock(mutex());
+      get().unshare(name);
     }
 
-    /*
-      CreationCore slicing management
-    */
-
-    /// returns the slice count of the CreationCore::DGNode this Port is connected to
-    unsigned int getSliceCount()
+    /// returns the name the operator name is bound as, which differs for aliases
+    static const char * resolve(const char * name)
     {
-      unsigned int result = FECS_Port_getSliceCount(mRef); 
-      Exception::MaybeThrow();
-      return result;
+      CreationCore::MutexLock lock(mutex());
+      Alias * alias = get().findAlias(name);
+      return alias != NULL ? alias->mSource->mCanonical : name;
     }
 
-    /// sets the slice count of the CreationCore::DGNode this Port is connected to
-    bool setSliceCount(unsigned int count)
+    /// returns the alias under which the node of state binds the operator
+    /// canonical, or NULL if it binds it under its canonical name
+    static const char * getAliasOnNode(NodeState * state, const char * canonical)
     {
-      bool result = FECS_Port_setSliceCount(mRef, count); 
-      Exception::MaybeThrow();
-      return result;
+      CreationCore::MutexLock lock(mutex());
+      Registry & registry = get();
+      Source * source = registry.findCanonical(canonical);
+      Alias * alias = source != NULL ? registry.findAliasOnNode(source, state) : NULL;
+      return alias != NULL ? alias->mName : NULL;
     }
 
-    /*
-      CreationCore::Variant IO
-    */
-
-    /// returns the value of a specific slice of this Port as a CreationCore::Variant
-    CreationCore::Variant getVariant(unsigned int slice = 0)
+    /// forgets the aliases bound on the node of state, called when the node
+    /// is cleared or its state goes away
+    static void releaseNode(NodeState * state)
     {
-      CreationCore::Variant result;
-      FECS_Port_getVariant(mRef, slice, result);
-      Exception::MaybeThrow();
-      return result;
+      CreationCore::MutexLock lock(mutex());
+      Registry & registry = get();
+      for(unsigned int i=registry.mAliasCount;i>0;i--)
+      {
+        Alias * alias = registry.mAliases[i-1];
+        if(!alias->hasNode(state))
+          continue;
+        Source * source = alias->mSource;
+        alias->removeNode(state);
+        if(alias->mNodeCount == 0)
+          registry.removeAlias(alias);
+        registry.release(source);
+      }
     }
 
-    /// sets the value of a specific slice of this Port from a CreationCore::Variant
-    bool setVariant(CreationCore::Variant value, unsigned int slice = 0)
+    /// drops every source and alias, called by Finalize() since the
+    /// operators they refer to are gone along with the runtime
+    static void reset()
     {
-      bool result = FECS_Port_setVariant(mRef, value, slice);
-      Exception::MaybeThrow();
-      return result;
+      CreationCore::MutexLock lock(mutex());
+      Registry & registry = get();
+      while(registry.mAliasCount > 0)
+        registry.removeAlias(registry.mAliases[0]);
+      while(registry.mSourceCount > 0)
+        registry.removeSource(registry.mSources[0]);
+      free(registry.mAliases);
+      free(registry.mSources);
+      free(registry.mSourcesByHash);
+      free(registry.mSourcesByName);
+      free(registry.mAliasesByName);
+      registry.mAliases = NULL;
+      registry.mSources = NULL;
+      registry.mSourcesByHash = NULL;
+      registry.mSourcesByName = NULL;
+      registry.mAliasesByName = NULL;
+      registry.mBucketMask = 0;
     }
 
-    /// returns the value of a specific slice of this Port as a JSON string
-    CreationCore::Variant getJSON(unsigned int slice = 0)
+    /// returns the source code an alias was constructed with,
+    /// or NULL if name is not an alias
+    static const char * getAliasSourceCode(const char * name)
     {
-      CreationCore::Variant result;
-      FECS_Port_getJSON(mRef, slice, result);
-      Exception::MaybeThrow();
-      return result;
+      CreationCore::MutexLock lock(mutex());
+      Alias * alias = get().findAlias(name);
+      return alias != NULL ? alias->mSourceCode : NULL;
     }
 
-    /// sets the value of a specific slice of this Port from a JSON string
-    bool setJSON(const char * json, unsigned int slice = 0)
+    /// returns the number of distinct sources in the registry
+    static unsigned int getSourceCount()
     {
-      bool result = FECS_Port_setJSON(mRef, json, slice);
-      Exception::MaybeThrow();
-      return result;
+      CreationCore::MutexLock lock(mutex());
+      return get().mSourceCount;
     }
 
-    /// returns the default value of this Port as a CreationCore::Variant
-    CreationCore::Variant getDefault()
+    /// returns the number of names bound to another name's operator
+    static unsigned int getAliasCount()
     {
-      CreationCore::Variant result;
-      FECS_Port_getDefault(mRef, result);
-      Exception::MaybeThrow();
-      return result;
+      CreationCore::MutexLock lock(mutex());
+      return get().mAliasCount;
     }
 
-    /*
-      High Performance IO
-      void* access to the internal data of the CreationCore::DGNode is only possible
-      for shallow data types (like Vec3 for example).
-    */
+  private:
 
-    /// returns the size of an array member this Port is connected to
-    unsigned int getArrayCount(unsigned int slice = 0)
-    {
-      unsigned int result = FECS_Port_getArrayCount(mRef, slice);
-      Exception::MaybeThrow();
+    struct Alias;
+
+    struct Source
+    {
+      uint32_t mHash;
+      uint32_t mNameHash;
+      char * mNormalized;
+      char * mCanonical;
+      unsigned int mRefs;
+      unsigned int mIndex;
+      Source * mNextByHash;
+      Source * mNextByName;
+      Alias * mAliases;
+    };
+
+    struct Alias
+    {
+      char * mName;
+      char * mSourceCode;
+      uint32_t mNameHash;
+      unsigned int mIndex;
+      Source * mSource;
+      Alias * mNextByName;
+      Alias * mNextOfSource;
+      NodeState ** mNodes;
+      unsigned int mNodeCount;
+
+      int findNode(NodeState * state)
+      {
+        for(unsigned int i=0;i<mNodeCount;i++)
+        {
+          if(mNodes[i] == state)
+            return int(i);
+        }
+        return -1;
+      }
+
+      bool hasNode(NodeState * state)
+      {
+        return findNode(state) >= 0;
+      }
+
+      void addNode(NodeState * state)
+      {
+        NodeState ** nodes = (NodeState **)realloc(mNodes, (mNodeCount + 1) * sizeof(NodeState *));
+        if(nodes == NULL)
+          Exception::Throw("KLOperatorRegistry: out of memory");
+        mNodes = nodes;
+        mNodes[mNodeCount++] = state;
+      }
+
+      void removeNode(NodeState * state)
+      {
+        int index = findNode(state);
+        if(index < 0)
+          return;
+        mNodes[index] = mNodes[--mNodeCount];
+      }
+    };
+
+    /// sources are found by the hash of their normalized code and by their
+    /// canonical name, aliases by their name. every source also links the
+    /// aliases bound to it. the arrays keep everything for iteration
+    struct Registry
+    {
+      Source ** mSources;
+      unsigned int mSourceCount;
+      Alias ** mAliases;
+      unsigned int mAliasCount;
+      Source ** mSourcesByHash;
+      Source ** mSourcesByName;
+      Alias ** mAliasesByName;
+      unsigned int mBucketMask;
+
+      Registry()
+      {
+        mSources = NULL;
+        mSourceCount = 0;
+        mAliases = NULL;
+        mAliasCount = 0;
+        mSourcesByHash = NULL;
+        mSourcesByName = NULL;
+        mAliasesByName = NULL;
+        mBucketMask = 0;
+      }
+
+      Source * findSource(uint32_t hash, const char * normalized)
+      {
+        if(mSourcesByHash == NULL)
+          return NULL;
+        for(Source * source = mSourcesByHash[hash & mBucketMask];source != NULL;source = source->mNextByHash)
+        {
+          if(source->mHash == hash && strcmp(source->mNormalized, normalized) == 0)
+            return source;
+        }
+        return NULL;
+      }
+
+      Source * findCanonical(const char * name)
+      {
+        if(mSourcesByName == NULL)
+          return NULL;
+        uint32_t hash = CreationCore::HashString(name);
+        for(Source * source = mSourcesByName[hash & mBucketMask];source != NULL;source = source->mNextByName)
+        {
+          if(source->mNameHash == hash && strcmp(source->mCanonical, name) == 0)
+            return source;
+        }
+        return NULL;
+      }
+
+      Alias * findAlias(const char * name)
+      {
+        if(mAliasesByName == NULL)
+          return NULL;
+        uint32_t hash = CreationCore::HashString(name);
+        for(Alias * alias = mAliasesByName[hash & mBucketMask];alias != NULL;alias = alias->mNextByName)
+        {
+          if(alias->mNameHash == hash && strcmp(alias->mName, name) == 0)
+            return alias;
+        }
+        return NULL;
+      }
+
+      /// returns the alias of source bound on the node of state, if any
+      Alias * findAliasOnNode(Source * source, NodeState * state)
+      {
+        for(Alias * alias = source->mAliases;alias != NULL;alias = alias->mNextOfSource)
+        {
+          if(alias->hasNode(state))
+            return alias;
+        }
+        return NULL;
+      }
+
+      /// makes room in the arrays for one more source and alias, and grows
+      /// the hash tables once they hold as many entries as buckets
+      void reserve()
+      {
+        Source ** sources = (Source **)realloc(mSources, (mSourceCount + 1) * sizeof(Source *));
+        if(sources == NULL)
+          Exception::Throw("KLOperatorRegistry: out of memory");
+        mSources = sources;
+        Alias ** aliases = (Alias **)realloc(mAliases, (mAliasCount + 1) * sizeof(Alias *));
+        if(aliases == NULL)
+          Exception::Throw("KLOperatorRegistry: out of memory");
+        mAliases = aliases;
+
+        unsigned int bucketCount = mBucketMask + 1;
+        if(mSourcesByHash != NULL && mSourceCount + mAliasCount < bucketCount)
+          return;
+        if(mSourcesByHash != NULL)
+          bucketCount *= 2;
+        else
+          bucketCount = 64;
+        Source ** sourcesByHash = (Source **)calloc(bucketCount, sizeof(Source *));
+        Source ** sourcesByName = (Source **)calloc(bucketCount, sizeof(Source *));
+        Alias ** aliasesByName = (Alias **)calloc(bucketCount, sizeof(Alias *));
+        if(sourcesByHash == NULL || sourcesByName == NULL || aliasesByName == NULL)
+        {
+          free(sourcesByHash);
+          free(sourcesByName);
+          free(aliasesByName);
+          Exception::Throw("KLOperatorRegistry: out of memory");
+        }
+        free(mSourcesByHash);
+        free(mSourcesByName);
+        free(mAliasesByName);
+        mSourcesByHash = sourcesByHash;
+        mSourcesByName = sourcesByName;
+        mAliasesByName = aliasesByName;
+        mBucketMask = bucketCount - 1;
+        for(unsigned int i=0;i<mSourceCount;i++)
+          link(mSources[i]);
+        for(unsigned int i=0;i<mAliasCount;i++)
+          link(mAliases[i]);
+      }
+
+      void link(Source * source)
+      {
+        source->mNextByHash = mSourcesByHash[source->mHash & mBucketMask];
+        mSourcesByHash[source->mHash & mBucketMask] = source;
+        source->mNextByName = mSourcesByName[source->mNameHash & mBucketMask];
+        mSourcesByName[source->mNameHash & mBucketMask] = source;
+      }
+
+      void link(Alias * alias)
+      {
+        alias->mNextByName = mAliasesByName[alias->mNameHash & mBucketMask];
+        mAliasesByName[alias->mNameHash & mBucketMask] = alias;
+      }
+
+      /// takes ownership of normalized
+      void addSource(uint32_t hash, char * normalized, const char * canonical)
+      {
+        char * name = duplicate(canonical);
+        if(name == NULL)
+        {
+          free(normalized);
+          Exception::Throw("KLOperatorRegistry: out of memory");
+        }
+        try
+        {
+          reserve();
+        }
+        catch(...)
+        {
+          free(normalized);
+          free(name);
+          throw;
+        }
+        Source * source = new Source();
+        source->mHash = hash;
+        source->mNameHash = CreationCore::HashString(name);
+        source->mNormalized = normalized;
+        source->mCanonical = name;
+        source->mRefs = 1;
+        source->mAliases = NULL;
+        source->mIndex = mSourceCount;
+        mSources[mSourceCount++] = source;
+        link(source);
+      }
+
+      Alias * addAlias(const char * name, const char * sourceCode, Source * source)
+      {
+        char * aliasName = duplicate(name);
+        char * aliasSourceCode = duplicate(sourceCode);
+        if(aliasName == NULL || aliasSourceCode == NULL)
+        {
+          free(aliasName);
+          free(aliasSourceCode);
+          Exception::Throw("KLOperatorRegistry: out of memory");
+        }
+        try
+        {
+          reserve();
+        }
+        catch(...)
+        {
+          free(aliasName);
+          free(aliasSourceCode);
+          throw;
+        }
+        Alias * alias = new Alias();
+        alias->mName = aliasName;
+        alias->mSourceCode = aliasSourceCode;
+        alias->mNameHash = CreationCore::HashString(aliasName);
+        alias->mSource = source;
+        alias->mNodes = NULL;
+        alias->mNodeCount = 0;
+        alias->mIndex = mAliasCount;
+        mAliases[mAliasCount++] = alias;
+        link(alias);
+        alias->mNextOfSource = source->mAliases;
+        source->mAliases = alias;
+        return alias;
+      }
+
+      void removeAlias(Alias * alias)
+      {
+        Alias ** link = &mAliasesByName[alias->mNameHash & mBucketMask];
+        while(*link != alias)
+          link = &(*link)->mNextByName;
+        *link = alias->mNextByName;
+        link = &alias->mSource->mAliases;
+        while(*link != alias)
+          link = &(*link)->mNextOfSource;
+        *link = alias->mNextOfSource;
+        mAliases[alias->mIndex] = mAliases[--mAliasCount];
+        mAliases[alias->mIndex]->mIndex = alias->mIndex;
+        free(alias->mNodes);
+        free(alias->mName);
+        free(alias->mSourceCode);
+        delete(alias);
+      }
+
+      /// the aliases of source have to be removed first
+      void removeSource(Source * source)
+      {
+        Source ** link = &mSourcesByHash[source->mHash & mBucketMask];
+        while(*link != source)
+          link = &(*link)->mNextByHash;
+        *link = source->mNextByHash;
+        link = &mSourcesByName[source->mNameHash & mBucketMask];
+        while(*link != source)
+          link = &(*link)->mNextByName;
+        *link = source->mNextByName;
+        mSources[source->mIndex] = mSources[--mSourceCount];
+        mSources[source->mIndex]->mIndex = source->mIndex;
+        free(source->mNormalized);
+        free(source->mCanonical);
+        delete(source);
+      }
+
+      void release(Source * source)
+      {
+        if(--source->mRefs == 0)
+          removeSource(source);
+      }
+
+      /// replaces the shared operator by an operator of its own on every
+      /// node binding the alias, keeping the binding's position. runs under
+      /// the registry mutex for all nodes at once, so failures are printed
+      /// and cleared from the Splice log instead of thrown halfway through
+      void detach(Alias * alias)
+      {
+        Source * source = alias->mSource;
+        // held until the alias is unlinked from it
+        source->mRefs++;
+        for(unsigned int i=0;i<alias->mNodeCount;i++)
+        {
+          FECS_NodeRef node = alias->mNodes[i]->getRef();
+          if(node == NULL)
+          {
+            release(source);
+            continue;
+          }
+          CreationCore::DGNode dgNode;
+          FECS_Node_getDGNode(node, dgNode);
+          CreationCore::DGBindingList bindings = dgNode.getBindingList();
+          unsigned int index = bindings.getCount();
+          for(unsigned int j=0;j<bindings.getCount();j++)
+          {
+            if(strcmp(bindings.getBinding(j).getOperator().getName(), source->mCanonical) == 0)
+            {
+              index = j;
+              break;
+            }
+          }
+          bool constructed = FECS_Node_removeKLOperator(node, source->mCanonical) &&
+            FECS_Node_constructKLOperator(node, alias->mName, alias->mSourceCode);
+          unsigned int count = bindings.getCount();
+          if(constructed && index + 1 < count)
+          {
+            CreationCore::DGBinding binding = bindings.getBinding(count - 1);
+            bindings.remove(count - 1);
+            bindings.insert(binding, index);
+          }
+          if(FECS_Logging_hasError())
+          {
+            printf("%s\n", FECS_Logging_getError());
+            FECS_Logging_clearError();
+          }
+          else if(!constructed)
+            printf("KLOperatorRegistry: unable to give operator %s its own copy\n", alias->mName);
+          release(source);
+        }
+        removeAlias(alias);
+        release(source);
+      }
+
+      void unshare(const char * name)
+      {
+        Alias * alias = findAlias(name);
+        if(alias != NULL)
+        {
+          detach(alias);
+          return;
+        }
+        Source * source = findCanonical(name);
+        if(source == NULL)
+          return;
+        // held so that detaching the last alias doesn't remove it
+        source->mRefs++;
+        while(source->mAliases != NULL)
+          detach(source->mAliases);
+        removeSource(source);
+      }
+    };
+
+    static Registry & get()
+    {
+      static Registry registry;
+      return registry;
+    }
+
+    static CreationCore::Mutex & mutex()
+    {
+      static CreationCore::Mutex mutex;
+      return mutex;
+    }
+
+    /// returns NULL if out of memory
+    static char * duplicate(const char * str)
+    {
+      size_t length = strlen(str) + 1;
+      char * result = (char *)malloc(length);
+      if(result != NULL)
+        memcpy(result, str, length);
       return result;
     }
 
-    /// returns the void* array data of this Port.
-    /// this only works for array Ports (isArray() == true)
-    /// the bufferSize has to match getArrayCount() * getDataSize()
-    bool getArrayData(void * buffer, unsigned int bufferSize, unsigned int slice = 0)
-    {
-      bool result = FECS_Port_getArrayData(mRef, buffer, bufferSize, slice);
-      Exception::MaybeThrow();
+    static bool isIdentifierChar(char c)
+    {
+      return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+
+    static bool isSeparatorChar(char c)
+    {
+      return c != '\0' && strchr("(){}[];,", c) != NULL;
+    }
+
+    /// drops comments and the whitespace next to brackets and separators,
+    /// collapses all other whitespace to a single space and replaces the
+    /// identifier name by a placeholder
+    static char * normalize(const char * sourceCode, const char * name)
+    {
+      size_t nameLength = strlen(name);
+      char * result = (char *)malloc(strlen(sourceCode) + 1);
+      if(result == NULL)
+        Exception::Throw("KLOperatorRegistry: out of memory");
+      size_t length = 0;
+      bool space = false;
+      const char * c = sourceCode;
+      while(*c)
+      {
+        if(c[0] == '/' && c[1] == '/')
+        {
+          while(*c && *c != '\n')
+            c++;
+          space = true;
+        }
+        else if(c[0] == '/' && c[1] == '*')
+        {
+          c += 2;
+          while(*c && !(c[0] == '*' && c[1] == '/'))
+            c++;
+          if(*c)
+            c += 2;
+          space = true;
+        }
+        else if(*c == ' ' || *c == '\t' || *c == '\n' || *c == '\r')
+        {
+          c++;
+          space = true;
+        }
+        else if(*c == '"' || *c == '\'')
+        {
+          if(space && length > 0 && !isSeparatorChar(result[length-1]))
+            result[length++] = ' ';
+          char quote = *c;
+          result[length++] = *c++;
+          while(*c && *c != quote)
+          {
+            if(*c == '\\' && c[1])
+              result[length++] = *c++;
+            result[length++] = *c++;
+          }
+          if(*c)
+            result[length++] = *c++;
+          space = false;
+        }
+        else if(isIdentifierChar(*c))
+        {
+          if(space && length > 0 && !isSeparatorChar(result[length-1]))
+            result[length++] = ' ';
+          const char * end = c;
+          while(isIdentifierChar(*end))
+            end++;
+          if(size_t(end - c) == nameLength && strncmp(c, name, nameLength) == 0)
+            result[length++] = '$';
+          else
+          {
+            memcpy(result + length, c, end - c);
+            length += end - c;
+          }
+          c = end;
+          space = false;
+        }
+        else
+        {
+          if(space && length > 0 && !isSeparatorChar(result[length-1]) && !isSeparatorChar(*c))
+            result[length++] = ' ';
+          result[length++] = *c++;
+          space = false;
+        }
+      }
+      result[length] = '\0';
       return result;
     }
+  };
 
-    /// sets the void* array data of this Port.
-    /// this only works for array Ports (isArray() == true)
-    /// this also sets the array count determined by bufferSize / getDataSize()
-    bool setArrayData(void * buffer, unsigned int bufferSize, unsigned int slice = 0)
-    {
-      bool result = FECS_Port_setArrayData(mRef, buffer, bufferSize, slice);
-      Exception::MaybeThrow();
-      return result;
+  inline void NodeState::releaseOperators()
+  {
+    KLOperatorRegistry::releaseNode(this);
+  }
+
+  inline NodeState::~NodeState()
+  {
+    KLOperatorRegistry::releaseNode(this);
+    destroy();
+  }
+
+  inline void Finalize()
+  {
+    KLOperatorRegistry::reset();
+    FECS_Finalize();
+    Exception::MaybeThrow();
+  }
+
+  /// reloads KL operators bound to files when the files change on disk.
+  /// the files are watched from a background thread, through inotify on
+  /// linux and by polling their modification time elsewhere, and the new
+  /// source is read there as well. applyPendingReloads() swaps the new
+  /// sources in and marks only the nodes binding the changed operators as
+  /// dirty, so it should be called between cooks from the main thread.
+  /// hosts poll hasPendingReloads() from their event loop, apply the
+  /// reloads and recook whatever owns a node that became dirty.
+  /// without thread support applyPendingReloads() polls the files itself
+  class KLOperatorFileWatcher
+  {
+  public:
+
+    /// starts watching filePath for operator name
+    static void watch(const char * name, const char * filePath)
+    {
+      Watcher & watcher = get();
+      CreationCore::MutexLock lock(watcher.mMutex);
+      Entry * entry = watcher.find(name);
+      if(entry == NULL)
+      {
+        entry = new Entry();
+        entry->mName = duplicate(name);
+        entry->mPath = NULL;
+        entry->mSource = NULL;
+        entry->mPending = NULL;
+        entry->mWatch = -1;
+        watcher.mEntries = (Entry **)realloc(watcher.mEntries, (watcher.mCount + 1) * sizeof(Entry *));
+        watcher.mEntries[watcher.mCount++] = entry;
+      }
+      watcher.removeWatch(*entry);
+      free(entry->mPath);
+      free(entry->mSource);
+      free(entry->mPending);
+      entry->mPath = duplicate(filePath);
+      entry->mSource = readFile(filePath);
+      entry->mPending = NULL;
+      stat(filePath, entry->mMTime, entry->mSize);
+      watcher.addWatch(*entry);
+      watcher.start();
+    }
+
+    /// stops watching the file of operator name
+    static void unwatch(const char * name)
+    {
+      Watcher & watcher = get();
+      CreationCore::MutexLock lock(watcher.mMutex);
+      for(unsigned int i=0;i<watcher.mCount;i++)
+      {
+        if(strcmp(watcher.mEntries[i]->mName, name) != 0)
+          continue;
+        watcher.removeWatch(*watcher.mEntries[i]);
+        destroy(watcher.mEntries[i]);
+        watcher.mEntries[i] = watcher.mEntries[--watcher.mCount];
+        return;
+      }
     }
 
-    /// gets the void* slice array data of this Port.
-    /// this only works for non-array Ports (isArray() == false)
-    /// the bufferSize has to match getSliceCount() * getDataSize()
-    bool getAllSlicesData(void * buffer, unsigned int bufferSize)
+    /// swaps in the sources of all changed files, marks the nodes binding
+    /// their operators as dirty and returns the number of reloaded operators
+    static unsigned int applyPendingReloads()
     {
-      bool result = FECS_Port_getAllSlicesData(mRef, buffer, bufferSize);
-      Exception::MaybeThrow();
+      Watcher & watcher = get();
+#if !defined(FEC_HAS_THREADS)
+      watcher.poll();
+#endif
+      unsigned int result = 0;
+      for(;;)
+      {
+        char * name = NULL;
+        char * source = NULL;
+        {
+          CreationCore::MutexLock lock(watcher.mMutex);
+          for(unsigned int i=0;i<watcher.mCount && name == NULL;i++)
+          {
+            Entry & entry = *watcher.mEntries[i];
+            if(entry.mPending == NULL)
+              continue;
+            name = duplicate(entry.mName);
+            source = entry.mPending;
+            entry.mPending = NULL;
+            free(entry.mSource);
+            entry.mSource = duplicate(source);
+          }
+        }
+        if(name == NULL)
+          break;
+
+        if(ExtensionDiscovery::isEnabled())
+          ExtensionDiscovery::require(source);
+        KLOperatorRegistry::unshare(name);
+        FECS_Node_setKLOperatorSourceCode(name, source);
+        CreationCore::BumpRTGeneration();
+        if(FECS_Logging_hasError())
+        {
+          printf("%s\n", FECS_Logging_getError());
+          FECS_Logging_clearError();
+        }
+        NodeState::markOperatorDirty(name);
+        free(name);
+        free(source);
+        result++;
+      }
+      watcher.mReloadCount += result;
       return result;
     }
 
-    /// sets the void* slice array data of this Port.
-    /// this only works for non-array Ports (isArray() == false)
-    /// the bufferSize has to match getSliceCount() * getDataSize()
-    bool setAllSlicesData(void * buffer, unsigned int bufferSize)
+    /// returns true if a watched file changed since the last
+    /// applyPendingReloads(). cheap enough to be polled from an event loop
+    static bool hasPendingReloads()
     {
-      bool result = FECS_Port_setAllSlicesData(mRef, buffer, bufferSize);
-      Exception::MaybeThrow();
-      return result;
+      Watcher & watcher = get();
+#if !defined(FEC_HAS_THREADS)
+      watcher.poll();
+#endif
+      CreationCore::MutexLock lock(watcher.mMutex);
+      for(unsigned int i=0;i<watcher.mCount;i++)
+      {
+        if(watcher.mEntries[i]->mPending != NULL)
+          return true;
+      }
+      return false;
     }
 
-    /// set the array data based on another port
-    /// this performs data replication, and only works on shallow array data ports.
-    /// the data type has to match as well (so only Vec3 to Vec3 for example).
-    bool copyArrayDataFromPort(Port other, unsigned int slice = 0, unsigned int otherSlice = UINT_MAX)
+    /// returns the number of watched operators
+    static unsigned int getWatchCount()
     {
-      bool result = FECS_Port_copyArrayDataFromPort(mRef, other.mRef, slice, otherSlice);
-      Exception::MaybeThrow();
-      return result;
+      Watcher & watcher = get();
+      CreationCore::MutexLock lock(watcher.mMutex);
+      return watcher.mCount;
     }
 
-    /// set the slices data based on another port
-    /// this performs data replication, and only works on shallow non array data ports.
-    /// the data type has to match as well (so only Vec3 to Vec3 for example).
-    bool copyAllSlicesDataFromPort(Port other, bool resizeTarget = false)
+    /// returns the number of operators reloaded so far
+    static uint64_t getReloadCount()
     {
-      bool result = FECS_Port_copyAllSlicesDataFromPort(mRef, other.mRef, resizeTarget);
-      Exception::MaybeThrow();
-      return result;
+      return get().mReloadCount;
     }
 
-    /*
-      Connection management
-    */
-
-    /// returns true if a port has connections
-    bool isConnected()
+    /// returns true if changes are detected through inotify rather than polling
+    static bool isUsingInotify()
     {
-      bool result = FECS_Port_isConnected(mRef);
-      Exception::MaybeThrow();
-      return result;
+      return get().mInotify >= 0;
     }
 
-    /// connects one Port to another one
-    bool connect(Port other)
+  private:
+
+    struct Entry
+    {
+      char * mName;
+      char * mPath;
+      char * mSource;
+      char * mPending;
+      int mWatch;
+      int64_t mMTime;
+      int64_t mSize;
+    };
+
+    struct Watcher
+    {
+      CreationCore::Mutex mMutex;
+      Entry ** mEntries;
+      unsigned int mCount;
+      uint64_t mReloadCount;
+      int mInotify;
+      bool mStarted;
+      volatile bool mStop;
+#if defined(FEC_HAS_THREADS)
+      pthread_t mThread;
+#endif
+
+      Watcher()
+      {
+        mEntries = NULL;
+        mCount = 0;
+        mReloadCount = 0;
+        mInotify = -1;
+        mStarted = false;
+        mStop = false;
+#if defined(__linux__)
+        mInotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+      }
+
+      ~Watcher()
+      {
+#if defined(FEC_HAS_THREADS)
+        if(mStarted)
+        {
+          mStop = true;
+          pthread_join(mThread, NULL);
+        }
+#endif
+#if defined(__linux__)
+        if(mInotify >= 0)
+          close(mInotify);
+#endif
+        for(unsigned int i=0;i<mCount;i++)
+          destroy(mEntries[i]);
+        free(mEntries);
+      }
+
+      Entry * find(const char * name)
+      {
+        for(unsigned int i=0;i<mCount;i++)
+        {
+          if(strcmp(mEntries[i]->mName, name) == 0)
+            return mEntries[i];
+        }
+        return NULL;
+      }
+
+      /// watches the directory rather than the file, since editors
+      /// usually save by replacing the file
+      void addWatch(Entry & entry)
+      {
+#if defined(__linux__)
+        if(mInotify < 0)
+          return;
+        char * directory = duplicate(entry.mPath);
+        char * slash = strrchr(directory, '/');
+        if(slash == directory)
+          slash[1] = '\0';
+        else if(slash != NULL)
+          slash[0] = '\0';
+        else
+          strcpy(directory, ".");
+        entry.mWatch = inotify_add_watch(mInotify, directory, IN_CLOSE_WRITE | IN_MOVED_TO);
+        free(directory);
+#else
+        (void)entry;
+#endif
+      }
+
+      /// drops the watch of entry's directory unless another entry's file
+      /// lives in the same directory, which shares the watch descriptor
+      void removeWatch(Entry & entry)
+      {
+#if defined(__linux__)
+        if(mInotify < 0 || entry.mWatch < 0)
+          return;
+        int wd = entry.mWatch;
+        entry.mWatch = -1;
+        for(unsigned int i=0;i<mCount;i++)
+        {
+          if(mEntries[i]->mWatch == wd)
+            return;
+        }
+        inotify_rm_watch(mInotify, wd);
+#else
+        (void)entry;
+#endif
+      }
+
+      void start()
+      {
+#if defined(FEC_HAS_THREADS)
+        if(mStarted)
+          return;
+        mStarted = pthread_create(&mThread, NULL, &ThreadMain, this) == 0;
+#endif
+      }
+
+      /// reads the files of all entries whose modification time or size
+      /// changed, or only those in the inotify watch wd when it is given
+      void poll(int wd = -1, const char * fileName = NULL)
+      {
+        CreationCore::MutexLock lock(mMutex);
+        for(unsigned int i=0;i<mCount;i++)
+        {
+          Entry & entry = *mEntries[i];
+          if(wd >= 0)
+          {
+            const char * slash = strrchr(entry.mPath, '/');
+            const char * baseName = slash != NULL ? slash + 1 : entry.mPath;
+            if(entry.mWatch != wd || strcmp(baseName, fileName) != 0)
+              continue;
+          }
+          int64_t mtime = 0;
+          int64_t size = 0;
+          if(!stat(entry.mPath, mtime, size))
+            continue;
+          if(wd < 0 && mtime == entry.mMTime && size == entry.mSize)
+            continue;
+          entry.mMTime = mtime;
+          entry.mSize = size;
+          char * source = readFile(entry.mPath);
+          if(source == NULL)
+            continue;
+          const char * current = entry.mPending != NULL ? entry.mPending : entry.mSource;
+          if(current != NULL && strcmp(current, source) == 0)
+          {
+            free(source);
+            continue;
+          }
+          free(entry.mPending);
+          entry.mPending = source;
+        }
+      }
+
+#if defined(FEC_HAS_THREADS)
+      static void * ThreadMain(void * userdata)
+      {
+        Watcher & watcher = *static_cast<Watcher *>(userdata);
+        while(!watcher.mStop)
+        {
+#if defined(__linux__)
+          if(watcher.mInotify >= 0)
+          {
+            struct pollfd fd;
+            fd.fd = watcher.mInotify;
+            fd.events = POLLIN;
+            if(::poll(&fd, 1, 250) <= 0)
+              continue;
+            char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+            ssize_t length;
+            while((length = read(watcher.mInotify, buffer, sizeof(buffer))) > 0)
+            {
+              for(char * ptr = buffer;ptr < buffer + length;)
+              {
+                struct inotify_event * event = (struct inotify_event *)ptr;
+                if(event->len > 0)
+                  watcher.poll(event->wd, event->name);
+                ptr += sizeof(struct inotify_event) + event->len;
+              }
+            }
+            continue;
+          }
+#endif
+          usleep(500000);
+          watcher.poll();
+        }
+        return NULL;
+      }
+#endif
+    };
+
+    static Watcher & get()
     {
-      bool result = FECS_Port_connect(mRef, other.mRef);
-      Exception::MaybeThrow();
-      return result;
+      static Watcher watcher;
+      return watcher;
     }
 
-    /// disconnects all connected Ports
-    bool disconnect()
+    static char * duplicate(const char * str)
     {
-      bool result = FECS_Port_disconnect(mRef);
-      Exception::MaybeThrow();
+      size_t length = strlen(str) + 1;
+      char * result = (char *)malloc(length);
+      memcpy(result, str, length);
       return result;
     }
 
-    /// return the number of connected ports
-    unsigned int getConnectionCount()
+    static void destroy(Entry * entry)
     {
-      bool result = FECS_Port_getConnectionCount(mRef);
-      Exception::MaybeThrow();
-      return result;
+      free(entry->mName);
+      free(entry->mPath);
+      free(entry->mSource);
+      free(entry->mPending);
+      delete(entry);
     }
 
-    /// return a connected port
-    Port getConnection(unsigned int index)
+    static bool stat(const char * filePath, int64_t & mtime, int64_t & size)
     {
-      Port connection;
-      connection.mRef = FECS_Port_getConnection(mRef, index);
-      Exception::MaybeThrow();
-      return connection;
+      struct ::stat info;
+      if(::stat(filePath, &info) != 0)
+        return false;
+      mtime = int64_t(info.st_mtime);
+      size = int64_t(info.st_size);
+      return true;
     }
 
-  private:
-    Port(FECS_PortRef ref)
-    { 
-      mRef = ref;
+    static char * readFile(const char * filePath)
+    {
+      FILE * file = fopen(filePath, "rb");
+      if(file == NULL)
+        return NULL;
+      fseek(file, 0, SEEK_END);
+      long length = ftell(file);
+      fseek(file, 0, SEEK_SET);
+      if(length < 0)
+      {
+        fclose(file);
+        return NULL;
+      }
+      char * result = (char *)malloc(size_t(length) + 1);
+      size_t read = fread(result, 1, size_t(length), file);
+      result[read] = '\0';
+      fclose(file);
+      return result;
     }
-    FECS_PortRef mRef;
   };
 
+  class KLOperatorBatch;
+
   class Node
   {
+    friend class KLOperatorBatch;
+
   public:
+
+    /// the optimization tier of a node. a node constructed with
+    /// ClientOptimizationType_None compiles its operators quickly but
+    /// unoptimized, every other node is optimized
+    enum Tier
+    {
+      Tier_Fast,
+      Tier_Optimized
+    };
     
     Node()
     { 
-      mRef = NULL;
+      mState = new NodeState();
+      mPortCache = NULL;
+      mPortLayoutVersion = 0;
+      initTiering(-1, CreationCore::ClientOptimizationType_Synchronous);
     }
 
     Node(const char * name, int guarded = -1, CreationCore::ClientOptimizationType optType = CreationCore::ClientOptimizationType_Synchronous)
     { 
-      mRef = FECS_Node_construct(name, guarded, optType); 
+      mState = new NodeState();
+      mState->setRef(FECS_Node_construct(name, guarded, optType));
+      mPortCache = NULL;
+      mPortLayoutVersion = 0;
+      initTiering(guarded, optType);
     }
 
     Node(Node const & other)
     {
-      mRef = FECS_Node_copy(other.mRef);
+      mState = other.mState;
+      mState->retain();
+      mState->retainNode();
+      mPortCache = NULL;
+      mPortLayoutVersion = 0;
+      copyTiering(other);
     }
 
     Node & operator =( Node const & other )
     {
-      FECS_Node_destroy(mRef);
-      mRef = FECS_Node_copy(other.mRef);
+      other.mState->retain();
+      other.mState->retainNode();
+      mState->releaseNode();
+      NodeState::release(mState);
+      mState = other.mState;
+      invalidatePortCache();
+      copyTiering(other);
       return *this;
     }
 
     ~Node()
     {
-      FECS_Node_destroy(mRef);
+      delete(mPortCache);
+      mState->releaseNode();
+      NodeState::release(mState);
     }
 
     /// returns true if the object is valid
     bool isValid()
     {
-      return mRef != NULL;
+      return ref() != NULL;
     }
 
     /// empties the content of the node
     void clear()
     {
-      FECS_Node_clear(mRef);
+      FECS_Node_clear(ref());
+      mState->releaseOperators();
+      mState->markDirty();
+      invalidatePortCache();
     }
 
     /// sets the name and ensures name uniqueness
     bool setName(const char * name)
     {
-      return FECS_Node_setName(mRef, name);
+      return FECS_Node_setName(ref(), name);
     }
 
     /*
       DG node management
     */
     
-    /// returns the internal CreationCore::DGNode
+    /// returns the internal CreationCore::DGNode.
+    /// writes through the DGNode bypass the dirty tracking, so from here on
+    /// evaluateIfDirty() always evaluates this node
     CreationCore::DGNode getDGNode()
     {
       CreationCore::DGNode dgNode;
-      FECS_Node_getDGNode(mRef, dgNode);
+      FECS_Node_getDGNode(ref(), dgNode);
+      mState->setUntracked();
+      return dgNode;
     }
     
     /// adds a member based on a member name and type (rt)
     bool addMember(const char * name, const char * rt, CreationCore::Variant defaultValue = CreationCore::Variant())
     {
-      bool result = FECS_Node_addMember(mRef, name, rt, defaultValue);
+      if(ExtensionDiscovery::isEnabled())
+        ExtensionDiscovery::requireType(rt);
+      bool result = FECS_Node_addMember(ref(), name, rt, defaultValue);
+      mState->markDirty();
       Exception::MaybeThrow();
       return result;
     }
@@ -737,7 +3124,7 @@ namespace CreationSplice
     /// returns true if a specific member exists
     bool hasMember(const char * name)
     {
-      bool result = FECS_Node_hasMember(mRef, name);
+      bool result = FECS_Node_hasMember(ref(), name);
       Exception::MaybeThrow();
       return result;
     }
@@ -745,7 +3132,9 @@ namespace CreationSplice
     /// removes a member
     bool removeMember(const char * name)
     {
-      bool result = FECS_Node_removeMember(mRef, name);
+      bool result = FECS_Node_removeMember(ref(), name);
+      mState->markDirty();
+      invalidatePortCache();
       Exception::MaybeThrow();
       return result;
     }
@@ -754,17 +3143,29 @@ namespace CreationSplice
       DG operator management
     */
 
-    /// constructs a CreationCore::DGOperator based on a name and a kl source string
+    /// constructs a CreationCore::DGOperator based on a name and a kl source string.
+    /// if an operator with the same source was constructed before under another
+    /// name, that operator is bound instead, see KLOperatorRegistry
     bool constructKLOperator(const char * name, const char * sourceCode = "")
     {
-      bool result = FECS_Node_constructKLOperator(mRef, name, sourceCode);
+      if(sourceCode != NULL && ExtensionDiscovery::isEnabled())
+        ExtensionDiscovery::require(sourceCode);
+      bool compiled = false;
+      bool result = KLOperatorRegistry::construct(mState, name, sourceCode, &compiled);
+      if(compiled)
+        CreationCore::BumpRTGeneration();
+      if(result)
+        mState->addOperator(name);
+      mState->markDirty();
       Exception::MaybeThrow();
       return result;
     }
 
     bool removeKLOperator(const char * name)
     {
-      bool result = FECS_Node_removeKLOperator(mRef, name);
+      bool result = KLOperatorRegistry::remove(mState, name);
+      mState->removeOperator(name);
+      mState->markDirty();
       Exception::MaybeThrow();
       return result;
     }
@@ -772,6 +3173,9 @@ namespace CreationSplice
     /// gets the source code of a specific CreationCore::DGOperator
     static CreationCore::Variant getKLOperatorSourceCode(const char * name)
     {
+      const char * aliasSourceCode = KLOperatorRegistry::getAliasSourceCode(name);
+      if(aliasSourceCode != NULL)
+        return CreationCore::Variant::CreateString(aliasSourceCode);
       CreationCore::Variant result; 
       FECS_Node_getKLOperatorSourceCode(name, result);
       Exception::MaybeThrow();
@@ -781,36 +3185,66 @@ namespace CreationSplice
     /// sets the source code of a specific CreationCore::DGOperator
     static bool setKLOperatorSourceCode(const char * name, const char * sourceCode)
     {
+      if(sourceCode != NULL && ExtensionDiscovery::isEnabled())
+        ExtensionDiscovery::require(sourceCode);
+      KLOperatorRegistry::unshare(name);
       bool result = FECS_Node_setKLOperatorSourceCode(name, sourceCode);
+      NodeState::bumpOperatorEpoch();
+      if(result)
+        CreationCore::BumpRTGeneration();
       Exception::MaybeThrow();
       return result;
     }
 
-    /// loads the source code of a specific CreationCore::DGOperator from file
+    /// loads the source code of a specific CreationCore::DGOperator from file.
+    /// later edits of the file are picked up by KLOperatorFileWatcher
     static void loadKLOperatorSourceCode(const char * name, const char * filePath)
     {
+      if(ExtensionDiscovery::isEnabled())
+        ExtensionDiscovery::requireFile(filePath);
+      KLOperatorRegistry::unshare(name);
       FECS_Node_loadKLOperatorSourceCode(name, filePath);
+      NodeState::bumpOperatorEpoch();
+      CreationCore::BumpRTGeneration();
       Exception::MaybeThrow();
+      KLOperatorFileWatcher::watch(name, filePath);
     }
 
     /// saves the source code of a specific CreationCore::DGOperator to file
     static void saveKLOperatorSourceCode(const char * name, const char * filePath)
     {
+      const char * aliasSourceCode = KLOperatorRegistry::getAliasSourceCode(name);
+      if(aliasSourceCode != NULL)
+      {
+        FILE * file = fopen(filePath, "wb");
+        if(file == NULL)
+          Exception::Throw("Node::saveKLOperatorSourceCode: unable to open file");
+        fwrite(aliasSourceCode, 1, strlen(aliasSourceCode), file);
+        fclose(file);
+        return;
+      }
       FECS_Node_saveKLOperatorSourceCode(name, filePath);
       Exception::MaybeThrow();
     }
 
-    /// loads the content of the file and sets the code
+    /// loads the content of the file and sets the code.
+    /// later edits of the file are picked up by KLOperatorFileWatcher
     static void setKLOperatorFilePath(const char * name, const char * filePath)
     {
+      if(ExtensionDiscovery::isEnabled())
+        ExtensionDiscovery::requireFile(filePath);
+      KLOperatorRegistry::unshare(name);
       FECS_Node_setKLOperatorFilePath(name, filePath);
+      NodeState::bumpOperatorEpoch();
+      CreationCore::BumpRTGeneration();
       Exception::MaybeThrow();
+      KLOperatorFileWatcher::watch(name, filePath);
     }
 
     /// returns the number of operators in this node
     unsigned int getKLOperatorCount()
     {
-      unsigned int result = FECS_Node_getKLOperatorCount(mRef);
+      unsigned int result = FECS_Node_getKLOperatorCount(ref());
       Exception::MaybeThrow();
       return result;
     }
@@ -819,8 +3253,14 @@ namespace CreationSplice
     CreationCore::Variant getKLOperatorName(unsigned int index = false)
     {
       CreationCore::Variant result; 
-      FECS_Node_getKLOperatorName(mRef, index, result);
-      Exception::MaybeThrow();
+      FECS_Node_getKLOperatorName(ref(), index, result);
+      Exception::MaybeThrow();
+      if(result.isString())
+      {
+        const char * alias = KLOperatorRegistry::getAliasOnNode(mState, result.getString_cstr());
+        if(alias != NULL)
+          return CreationCore::Variant::CreateString(alias);
+      }
       return result;
     }
 
@@ -856,15 +3296,196 @@ namespace CreationSplice
     /// evaluates the contained DGNode
     bool evaluate()
     {
-      bool result = FECS_Node_evaluate(mRef);
-      Exception::MaybeThrow();
+      bool tiered = getOptimizationTier() == Tier_Fast && (mTierEvalCount > 0 || mTierSeconds > 0.0);
+      double start = tiered ? CreationCore::GetSeconds() : 0.0;
+      bool result = FECS_Node_evaluate(ref());
+      Exception::MaybeThrow();
+      if(result)
+      {
+        mState->markEvaluated();
+        if(tiered)
+        {
+          mState->recordEvaluationTime(CreationCore::GetSeconds() - start);
+          if((mTierEvalCount > 0 && mState->getProfileCount() >= mTierEvalCount) ||
+            (mTierSeconds > 0.0 && mState->getProfileSeconds() >= mTierSeconds))
+            mState->setPromotionPending(true);
+        }
+      }
       return result;
     }
 
+    /// evaluates the contained DGNode only if something was written to this
+    /// node or to any node upstream of it through the C++ interface since
+    /// its last evaluation. the tracking is per node: operators with side
+    /// effects, time dependence or inputs the C++ interface can't see
+    /// should use evaluate(), or call markDirty() when those change
+    bool evaluateIfDirty()
+    {
+      if(!mState->needsEvaluate())
+        return true;
+      return evaluate();
+    }
+
+    /*
+      Tiered optimization
+    */
+
+    /// enables tiered optimization for a node constructed with
+    /// ClientOptimizationType_None. once the node has been evaluated
+    /// evalCount times, or its evaluations took seconds in total, it is
+    /// marked for promotion. evaluate() never promotes by itself, since
+    /// rebuilding the node takes far longer than an evaluation: call
+    /// promotePending() between cooks. a threshold of 0 disables that
+    /// criterion
+    void setOptimizationTiering(unsigned int evalCount, double seconds)
+    {
+      mTierEvalCount = evalCount;
+      mTierSeconds = seconds;
+    }
+
+    /// returns the current optimization tier of the node
+    Tier getOptimizationTier()
+    {
+      return mState->isPromoted() ? Tier_Optimized : mTier;
+    }
+
+    /// returns true if the node crossed its tiering threshold and waits
+    /// for promotePending()
+    bool isPromotionPending()
+    {
+      return mState->isPromotionPending() && getOptimizationTier() == Tier_Fast;
+    }
+
+    /// promotes the node if it crossed its tiering threshold. meant to be
+    /// called between cooks, returns true if the node was promoted
+    bool promotePending()
+    {
+      if(!isPromotionPending())
+        return false;
+      return promote();
+    }
+
+    /// rebuilds a Tier_Fast node with ClientOptimizationType_Background,
+    /// carrying over its persistence data and member values, and swaps the
+    /// rebuilt node in. the rebuild only compiles unoptimized code, the
+    /// runtime optimizes it on its own threads and switches to the
+    /// optimized code once that is done. the current node stays in use
+    /// until the rebuilt one is complete, so a failed promotion changes
+    /// nothing. the node is swapped in the state shared by all copies of
+    /// this Node, and Ports obtained before look up their port on the new
+    /// node on first use. nodes with connected ports are not promoted,
+    /// since connections can't be carried over. returns true if the node
+    /// was promoted, the reason for a failed promotion is printed
+    bool promote()
+    {
+      if(getOptimizationTier() != Tier_Fast || ref() == NULL)
+        return false;
+
+      // only a single attempt is made
+      mTierEvalCount = 0;
+      mTierSeconds = 0.0;
+      mState->setPromotionPending(false);
+
+      FECS_NodeRef optimized = NULL;
+      CreationCore::Variant name;
+      try
+      {
+        unsigned int portCount = getPortCount();
+        for(unsigned int i=0;i<portCount;i++)
+        {
+          CreationCore::Variant portName = getPortName(i);
+          if(getPortConnectionCount(portName.getString_cstr()) > 0)
+          {
+            printf("Node::promote: nodes with connected ports are not promoted\n");
+            return false;
+          }
+        }
+
+        CreationCore::Variant json = getPersistenceData();
+        CreationCore::DGNode dgNode;
+        FECS_Node_getDGNode(ref(), dgNode);
+        Exception::MaybeThrow();
+        name = CreationCore::Variant::CreateString(dgNode.getName());
+
+        // the name is still taken, it is set once the old node is gone
+        optimized = FECS_Node_construct(name.getString_cstr(), mGuarded, CreationCore::ClientOptimizationType_Background);
+        Exception::MaybeThrow();
+        bool result = optimized != NULL && FECS_Node_setFromPersistenceData(optimized, json);
+        Exception::MaybeThrow();
+        if(!result)
+        {
+          printf("Node::promote: unable to rebuild the node from its persistence data\n");
+          FECS_Node_destroy(optimized);
+          return false;
+        }
+
+        CreationCore::DGNode optimizedDGNode;
+        FECS_Node_getDGNode(optimized, optimizedDGNode);
+        Exception::MaybeThrow();
+        copyMemberData(dgNode, optimizedDGNode);
+      }
+      catch(Exception const &)
+      {
+        // already printed when thrown
+        printf("Node::promote: the node stays unoptimized\n");
+        FECS_Logging_clearError();
+        if(optimized != NULL)
+          FECS_Node_destroy(optimized);
+        return false;
+      }
+      catch(CreationCore::Exception const & e)
+      {
+        printf("Node::promote: %.*s\n", int(e.getDescLength()), e.getDescData());
+        if(optimized != NULL)
+          FECS_Node_destroy(optimized);
+        return false;
+      }
+      catch(...)
+      {
+        printf("Node::promote: unknown error, the node stays unoptimized\n");
+        if(optimized != NULL)
+          FECS_Node_destroy(optimized);
+        return false;
+      }
+
+      invalidatePortCache();
+      mState->setRef(optimized);
+      mState->setPromoted();
+      mTier = Tier_Optimized;
+      FECS_Node_setName(optimized, name.getString_cstr());
+      if(FECS_Logging_hasError())
+      {
+        printf("%s\n", FECS_Logging_getError());
+        FECS_Logging_clearError();
+      }
+      mState->markDirty();
+      recordOperators();
+      return true;
+    }
+
+    /// returns true if the next evaluateIfDirty() will run the node's operators
+    bool isDirty()
+    {
+      return mState->needsEvaluate();
+    }
+
+    /// marks the node as changed, for writes the C++ interface cannot see
+    void markDirty()
+    {
+      mState->markDirty();
+    }
+
+    /// returns true if a member has been written since the last evaluation
+    bool isMemberDirty(const char * name)
+    {
+      return mState->isMemberDirty(name);
+    }
+
     /// clears the evaluate state
     bool clearEvaluate()
     {
-      bool result = FECS_Node_clearEvaluate(mRef);
+      bool result = FECS_Node_clearEvaluate(ref());
+      mState->markDirty();
       Exception::MaybeThrow();
       return result;
     }
@@ -876,15 +3497,19 @@ namespace CreationSplice
     /// adds a new Port provided a name, the member and a mode
     Port addPort(const char * name, const char * member, CreationSplice::Port_Mode mode)
     {
-      FECS_PortRef result = FECS_Node_addPort(mRef, name, member, (FECS_Port_Mode)mode);
+      FECS_PortRef result = FECS_Node_addPort(ref(), name, member, (FECS_Port_Mode)mode);
+      mState->markDirty();
+      invalidatePortCache();
       Exception::MaybeThrow();
-      return Port(result);
+      return Port(result, mState);
     }
 
     /// removes an existing Port by name
     bool removePort(const char * name)
     {
-      bool result = FECS_Node_removePort(mRef, name);
+      bool result = FECS_Node_removePort(ref(), name);
+      mState->markDirty();
+      invalidatePortCache();
       Exception::MaybeThrow();
       return result;
     }
@@ -892,15 +3517,53 @@ namespace CreationSplice
     /// returns a specific Port by name
     Port getPort(const char * name)
     {
-      FECS_PortRef result = FECS_Node_getPort(mRef, name);
+      FECS_PortRef result = FECS_Node_getPort(ref(), name);
       Exception::MaybeThrow();
-      return Port(result);
+      return Port(result, mState);
+    }
+
+    /*
+      Cached port access
+      the node keeps a name-to-port index which is built on first use and
+      dropped whenever the port layout changes (addPort, removePort, clear,
+      removeMember, setFromPersistenceData, loadFromFile). port indices and
+      Port references returned from here are valid until then.
+    */
+
+    /// returns the index of a Port by name, or -1 if there is no such Port
+    int getPortIndex(const char * name)
+    {
+      return getPortCache().find(name);
+    }
+
+    /// returns a cached Port by index, see getPortIndex
+    Port & getCachedPort(unsigned int index)
+    {
+      NodePortCache & cache = getPortCache();
+      if(index >= cache.getCount())
+        Exception::Throw("Node::getCachedPort: port index out of range");
+      return cache.getPort(index);
+    }
+
+    /// returns a cached Port by name
+    Port & getCachedPort(const char * name)
+    {
+      int index = getPortIndex(name);
+      if(index < 0)
+        Exception::Throw("Node::getCachedPort: port not found");
+      return getPortCache().getPort((unsigned int)index);
+    }
+
+    /// returns a counter which changes every time the cached port layout is dropped
+    unsigned int getPortLayoutVersion()
+    {
+      return mPortLayoutVersion;
     }
 
     /// returns the number of ports in this node
     unsigned int getPortCount()
     {
-      unsigned int result = FECS_Node_getPortCount(mRef);
+      unsigned int result = FECS_Node_getPortCount(ref());
       Exception::MaybeThrow();
       return result;
     }
@@ -909,7 +3572,7 @@ namespace CreationSplice
     CreationCore::Variant getPortName(unsigned int index)
     {
       CreationCore::Variant result; 
-      FECS_Node_getPortName(mRef, index, result);
+      FECS_Node_getPortName(ref(), index, result);
       Exception::MaybeThrow();
       return result;
     }
@@ -918,7 +3581,7 @@ namespace CreationSplice
     CreationCore::Variant getPortGroup(const char * name)
     {
       CreationCore::Variant result; 
-      FECS_Node_getPortGroup(mRef, name, result);
+      FECS_Node_getPortGroup(ref(), name, result);
       Exception::MaybeThrow();
       return result;
     }
@@ -930,15 +3593,18 @@ namespace CreationSplice
     /// connects one Port to another one
     bool connectPorts(const char * port, Node & otherNode, const char * otherPort)
     {
-      bool result = FECS_Node_connectPorts(mRef, port, otherNode.mRef, otherPort);
+      bool result = FECS_Node_connectPorts(ref(), port, otherNode.ref(), otherPort);
       Exception::MaybeThrow();
+      if(result)
+        getCachedPort(port).linkStates(otherNode.getCachedPort(otherPort));
       return result;
     }
 
     /// disconnects a Port based on its name
     bool disconnectPort(const char * name)
     {
-      bool result = FECS_Node_disconnectPort(mRef, name);
+      bool result = FECS_Node_disconnectPort(ref(), name);
+      mState->markDirty();
       Exception::MaybeThrow();
       return result;
     }
@@ -946,7 +3612,7 @@ namespace CreationSplice
     /// returns all connected Ports of a specific Port
     unsigned int getPortConnectionCount(const char * name)
     {
-      unsigned int result = FECS_Node_getPortConnectionCount(mRef, name);
+      unsigned int result = FECS_Node_getPortConnectionCount(ref(), name);
       Exception::MaybeThrow();
       return result;
     }
@@ -954,7 +3620,7 @@ namespace CreationSplice
     /// returns all connected Ports of a specific Port
     Port getPortConnection(const char * name, unsigned int index)
     {
-      FECS_PortRef result = FECS_Node_getPortConnection(mRef, name, index);
+      FECS_PortRef result = FECS_Node_getPortConnection(ref(), name, index);
       Exception::MaybeThrow();
       return Port(result);
     }
@@ -963,7 +3629,7 @@ namespace CreationSplice
     CreationCore::Variant getPortInfo()
     {
       CreationCore::Variant result;
-      FECS_Node_getPortInfo(mRef, result);
+      FECS_Node_getPortInfo(ref(), result);
       Exception::MaybeThrow();
       return result;
     }
@@ -972,7 +3638,7 @@ namespace CreationSplice
     CreationCore::Variant getPersistenceData()
     {
       CreationCore::Variant result;
-      FECS_Node_getPersistenceData(mRef, result);
+      FECS_Node_getPersistenceData(ref(), result);
       Exception::MaybeThrow();
       return result;
     }
@@ -980,15 +3646,22 @@ namespace CreationSplice
     /// constructs the node based on a JSON string
     bool setFromPersistenceData(const CreationCore::Variant & json)
     {
-      bool result = FECS_Node_setFromPersistenceData(mRef, json);
+      if(ExtensionDiscovery::isEnabled())
+        ExtensionDiscovery::requireData(json);
+      bool result = FECS_Node_setFromPersistenceData(ref(), json);
+      if(result)
+        CreationCore::BumpRTGeneration();
+      mState->markDirty();
+      invalidatePortCache();
       Exception::MaybeThrow();
+      recordOperators();
       return result;
     }
 
     /// persists the node description into a JSON file
     bool saveToFile(const char * filePath)
     {
-      bool result = FECS_Node_saveToFile(mRef, filePath);
+      bool result = FECS_Node_saveToFile(ref(), filePath);
       Exception::MaybeThrow();
       return result;
     }
@@ -996,14 +3669,21 @@ namespace CreationSplice
     /// constructs the node based on a persisted JSON file
     bool loadFromFile(const char * filePath)
     {
-      bool result = FECS_Node_loadFromFile(mRef, filePath);
+      if(ExtensionDiscovery::isEnabled())
+        ExtensionDiscovery::requireDataFile(filePath);
+      bool result = FECS_Node_loadFromFile(ref(), filePath);
+      if(result)
+        CreationCore::BumpRTGeneration();
+      mState->markDirty();
+      invalidatePortCache();
       Exception::MaybeThrow();
+      recordOperators();
       return result;
     }
 
     /// marks a member to be persisted
     void setMemberPersistance(const char * name, bool persistance){
-      FECS_Node_setMemberPersistance(mRef, name, persistance);
+      FECS_Node_setMemberPersistance(ref(), name, persistance);
       Exception::MaybeThrow();
     }
 
@@ -1014,17 +3694,331 @@ namespace CreationSplice
     /// set the filter for valid KL extensions
     static void setExtFilter(FECS_FilterFunc filter)
     {
-      FECS_Node_setExtFilter(filter);
+      ExtensionDiscovery::setExtFilter(filter);
     }
 
     /// set the filter for valid KL registered types
     static void setRTFilter(FECS_FilterFunc filter)
     {
-      FECS_Node_setRTFilter(filter);
+      ExtensionDiscovery::setRTFilter(filter);
     }
 
   private:
-    FECS_NodeRef mRef;
+
+    /// records the operators of the node in its NodeState, for operators
+    /// constructed by the runtime rather than by constructKLOperator
+    void recordOperators()
+    {
+      unsigned int count = FECS_Node_getKLOperatorCount(ref());
+      Exception::MaybeThrow();
+      for(unsigned int i=0;i<count;i++)
+      {
+        CreationCore::Variant name;
+        FECS_Node_getKLOperatorName(ref(), i, name);
+        Exception::MaybeThrow();
+        if(name.isString())
+          mState->addOperator(name.getString_cstr());
+      }
+    }
+
+    /// the wrapped node lives in the shared state, so that a promotion
+    /// replaces it for every copy of this Node
+    FECS_NodeRef ref() const
+    {
+      return mState->getRef();
+    }
+
+    void initTiering(int guarded, CreationCore::ClientOptimizationType optType)
+    {
+      mGuarded = guarded;
+      mTier = optType == CreationCore::ClientOptimizationType_None ? Tier_Fast : Tier_Optimized;
+      mTierEvalCount = 0;
+      mTierSeconds = 0.0;
+    }
+
+    void copyTiering(Node const & other)
+    {
+      mGuarded = other.mGuarded;
+      mTier = other.mTier;
+      mTierEvalCount = other.mTierEvalCount;
+      mTierSeconds = other.mTierSeconds;
+    }
+
+    /// copies the slice count and the values of every member of source
+    /// which target also has
+    static void copyMemberData(CreationCore::DGNode & source, CreationCore::DGNode & target)
+    {
+      uint32_t sliceCount = source.getSize();
+      target.setSize(sliceCount);
+      CreationCore::Variant members = source.getMembers_Variant();
+      CreationCore::Variant targetMembers = target.getMembers_Variant();
+      for(CreationCore::Variant::DictIter it(members);!it.isDone();it.next())
+      {
+        const char * member = it.getKey()->getString_cstr();
+        if(!targetMembers.getDictValue(member))
+          continue;
+        if(source.getMemberIsShallow(member))
+        {
+          uint64_t size = uint64_t(source.getMemberSize(member)) * sliceCount;
+          void * data = size <= 0xffffffffu ? malloc(size_t(size)) : NULL;
+          if(data == NULL && size > 0)
+            Exception::Throw("Node::promote: out of memory copying member data");
+          source.getMemberAllSlicesData(member, uint32_t(size), data);
+          target.setMemberAllSlicesData(member, uint32_t(size), data);
+          free(data);
+        }
+        else
+        {
+          for(uint32_t i=0;i<sliceCount;i++)
+          {
+            CreationCore::Variant value = source.getMemberSliceData_Variant(member, i);
+            target.setMemberSliceData_Variant(member, i, value);
+          }
+        }
+      }
+    }
+
+    NodePortCache & getPortCache()
+    {
+      if(mPortCache == NULL)
+      {
+        NodePortCache * cache = new NodePortCache();
+        try
+        {
+          unsigned int count = getPortCount();
+          for(unsigned int i=0;i<count;i++)
+          {
+            CreationCore::Variant name = getPortName(i);
+            FECS_PortRef port = FECS_Node_getPort(ref(), name.getString_cstr());
+            Exception::MaybeThrow();
+            cache->append(name.getString_cstr(), new Port(port, mState));
+          }
+        }
+        catch(...)
+        {
+          delete(cache);
+          throw;
+        }
+        cache->finalize();
+        mPortCache = cache;
+      }
+      return *mPortCache;
+    }
+
+    void invalidatePortCache()
+    {
+      delete(mPortCache);
+      mPortCache = NULL;
+      mPortLayoutVersion++;
+    }
+
+    NodeState * mState;
+    NodePortCache * mPortCache;
+    unsigned int mPortLayoutVersion;
+    int mGuarded;
+    Tier mTier;
+    unsigned int mTierEvalCount;
+    double mTierSeconds;
+  };
+
+  /// constructs the KL operators of a scene load in one go.
+  /// add() and addFromFile() only record the operators. compile()
+  /// constructs each of them on its node and collects its compile errors,
+  /// carrying on past operators that fail, so a scene load reports all of
+  /// its errors at once. the batch keeps a copy of every Node it was given.
+  /// operators are NOT compiled in parallel: the runtime compiles an
+  /// operator inside the call constructing it, and the Splice API offers
+  /// no way to construct operators concurrently or to compile them apart
+  /// from their construction, so compile() runs one operator at a time
+  class KLOperatorBatch
+  {
+  public:
+
+    KLOperatorBatch()
+    {
+      mEntries = NULL;
+      mCount = 0;
+    }
+
+    ~KLOperatorBatch()
+    {
+      clear();
+    }
+
+    /// records an operator to be constructed on node from source code
+    void add(Node & node, const char * name, const char * sourceCode)
+    {
+      append(node, name, sourceCode, NULL);
+    }
+
+    /// records an operator to be constructed on node from a KL file
+    void addFromFile(Node & node, const char * name, const char * filePath)
+    {
+      append(node, name, NULL, filePath);
+    }
+
+    /// constructs and compiles all recorded operators.
+    /// returns true if all of them compiled without errors
+    bool compile()
+    {
+      for(unsigned int i=0;i<mCount;i++)
+      {
+        Entry & entry = *mEntries[i];
+        try
+        {
+          if(entry.mFilePath)
+          {
+            entry.mNode.constructKLOperator(entry.mName);
+            Node::loadKLOperatorSourceCode(entry.mName, entry.mFilePath);
+          }
+          else
+            entry.mNode.constructKLOperator(entry.mName, entry.mSourceCode);
+          entry.mOperator = findOperator(entry.mNode, entry.mName);
+          if(entry.mOperator.isValid())
+            entry.mErrors = entry.mOperator.getErrors();
+        }
+        catch(Exception const & e)
+        {
+          entry.mErrors = CreationCore::Variant::CreateArray();
+          entry.mErrors.arrayAppend(CreationCore::Variant::CreateString(e.what()));
+          FECS_Logging_clearError();
+          entry.mFailed = true;
+        }
+        catch(CreationCore::Exception const & e)
+        {
+          entry.mErrors = CreationCore::Variant::CreateArray();
+          entry.mErrors.arrayAppend(CreationCore::Variant::CreateString(e.getDesc_cstr()));
+          entry.mFailed = true;
+        }
+      }
+
+      bool result = true;
+      for(unsigned int i=0;i<mCount;i++)
+      {
+        if(hasErrors(i))
+          result = false;
+      }
+      return result;
+    }
+
+    /// returns the number of recorded operators
+    unsigned int getCount()
+    {
+      return mCount;
+    }
+
+    /// returns the name of a recorded operator
+    const char * getName(unsigned int index)
+    {
+      return mEntries[index]->mName;
+    }
+
+    /// returns true if a recorded operator failed to compile
+    bool hasErrors(unsigned int index)
+    {
+      Entry & entry = *mEntries[index];
+      if(entry.mFailed || !entry.mOperator.isValid())
+        return true;
+      if(entry.mErrors.isArray())
+        return entry.mErrors.getArraySize() > 0;
+      if(entry.mErrors.isDict())
+        return !CreationCore::Variant::DictIter(entry.mErrors).isDone();
+      return false;
+    }
+
+    /// returns the compile errors of a recorded operator
+    CreationCore::Variant getErrors(unsigned int index)
+    {
+      return mEntries[index]->mErrors;
+    }
+
+    /// drops all recorded operators
+    void clear()
+    {
+      for(unsigned int i=0;i<mCount;i++)
+      {
+        free(mEntries[i]->mName);
+        free(mEntries[i]->mSourceCode);
+        free(mEntries[i]->mFilePath);
+        delete(mEntries[i]);
+      }
+      free(mEntries);
+      mEntries = NULL;
+      mCount = 0;
+    }
+
+  private:
+
+    KLOperatorBatch(KLOperatorBatch const &);
+    KLOperatorBatch & operator =(KLOperatorBatch const &);
+
+    struct Entry
+    {
+      Node mNode;
+      char * mName;
+      char * mSourceCode;
+      char * mFilePath;
+      CreationCore::DGOperator mOperator;
+      CreationCore::Variant mErrors;
+      bool mFailed;
+    };
+
+    static char * duplicate(const char * str)
+    {
+      if(str == NULL)
+        return NULL;
+      size_t length = strlen(str) + 1;
+      char * result = (char *)malloc(length);
+      if(result != NULL)
+        memcpy(result, str, length);
+      return result;
+    }
+
+    void append(Node & node, const char * name, const char * sourceCode, const char * filePath)
+    {
+      Entry ** entries = (Entry **)realloc(mEntries, (mCount + 1) * sizeof(Entry *));
+      if(entries == NULL)
+        Exception::Throw("KLOperatorBatch: out of memory");
+      mEntries = entries;
+      Entry * entry = new Entry();
+      entry->mNode = node;
+      entry->mName = duplicate(name);
+      entry->mSourceCode = duplicate(sourceCode);
+      entry->mFilePath = duplicate(filePath);
+      entry->mFailed = false;
+      if(entry->mName == NULL || (sourceCode != NULL && entry->mSourceCode == NULL) ||
+        (filePath != NULL && entry->mFilePath == NULL))
+      {
+        free(entry->mName);
+        free(entry->mSourceCode);
+        free(entry->mFilePath);
+        delete(entry);
+        Exception::Throw("KLOperatorBatch: out of memory");
+      }
+      mEntries[mCount++] = entry;
+    }
+
+    /// returns the operator bound on node for name. operators sharing their
+    /// source with another one are bound under the canonical name
+    static CreationCore::DGOperator findOperator(Node & node, const char * name)
+    {
+      name = KLOperatorRegistry::resolve(name);
+      CreationCore::DGNode dgNode;
+      FECS_Node_getDGNode(node.ref(), dgNode);
+      Exception::MaybeThrow();
+      CreationCore::DGBindingList bindings = dgNode.getBindingList();
+      unsigned int count = bindings.getCount();
+      for(unsigned int i=0;i<count;i++)
+      {
+        CreationCore::DGOperator dgOperator = bindings.getBinding(i).getOperator();
+        if(strcmp(dgOperator.getName(), name) == 0)
+          return dgOperator;
+      }
+      return CreationCore::DGOperator();
+    }
+
+    Entry ** mEntries;
+    unsigned int mCount;
   };
 }
 